@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "cs402.h"
+
+int gnRows = 1000000;
+char gszJobs[16] = "1";
+char gszAlgo[16] = "radix";
+
+void Usage(){
+    fprintf(stderr, "usage: bench [-rows=positive_integer] [-j=positive_integer] [-a=radix|merge]\n");
+    exit(1);
+}
+
+void ProcessOptions(int argc, char *argv[]){
+    for(int a = 1; a < argc; a++){
+        int jobs = 0;
+        if(strncmp(argv[a], "-rows=", 6) == 0){
+            if(sscanf(&argv[a][6], "%d", &gnRows) != 1 || gnRows <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-j=", 3) == 0){
+            if(sscanf(&argv[a][3], "%d", &jobs) != 1 || jobs <= 0 || jobs > 1024){
+                Usage();
+            }
+            snprintf(gszJobs, sizeof(gszJobs), "%d", jobs);
+        }
+        else if(strcmp(argv[a], "-a=radix") == 0 || strcmp(argv[a], "-a=merge") == 0){
+            snprintf(gszAlgo, sizeof(gszAlgo), "%s", &argv[a][3]);
+        }
+        else{
+            Usage();
+        }
+    }
+}
+
+/* runs argv with stdout and stderr sent to the given fds, returns its peak RSS in KB */
+long runChild(char* argv[], int outFd, int errFd){
+    pid_t pid = fork();
+    if(pid < 0){
+        fprintf(stderr, "Error fork in runChild.\n");
+        exit(1);
+    }
+    if(pid == 0){
+        dup2(outFd, 1);
+        dup2(errFd, 2);
+        execv(argv[0], argv);
+        fprintf(stderr, "Error running %s.\n", argv[0]);
+        _exit(1);
+    }
+    int status = 0;
+    struct rusage usage;
+    if(wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+        fprintf(stderr, "%s failed.\n", argv[0]);
+        exit(1);
+    }
+    return usage.ru_maxrss;
+}
+
+/* value of key=... in a warmup1 --stats line, 0 if it is not there */
+long long statsValue(const char* line, const char* key){
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), " %s=", key);
+    const char* found = strstr(line, pattern);
+    return found != NULL ? atoll(found + strlen(pattern)) : 0;
+}
+
+/* generates a tfile with ./tfilegen, then times ./warmup1 sort --stats on it */
+void runBench(const char* order){
+    char tfilePath[] = "/tmp/w1benchXXXXXX";
+    char errPath[] = "/tmp/w1benchXXXXXX";
+    int tfileFd = mkstemp(tfilePath);
+    int errFd = mkstemp(errPath);
+    int nullFd = open("/dev/null", O_WRONLY);
+    if(tfileFd < 0 || errFd < 0 || nullFd < 0){
+        fprintf(stderr, "Error creating temp files in runBench.\n");
+        exit(1);
+    }
+    unlink(errPath);
+
+    char rowsArg[32];
+    char orderArg[32];
+    snprintf(rowsArg, sizeof(rowsArg), "-rows=%d", gnRows);
+    snprintf(orderArg, sizeof(orderArg), "-order=%s", order);
+    char* genArgv[] = {"./tfilegen", rowsArg, orderArg, NULL};
+    runChild(genArgv, tfileFd, 2);
+
+    char* sortArgv[] = {"./warmup1", "sort", "--stats", "-j", gszJobs, "-a", gszAlgo, tfilePath, NULL};
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    long peakRSS = runChild(sortArgv, nullFd, errFd);
+    gettimeofday(&end, NULL);
+    unlink(tfilePath);
+
+    char line[1024] = "";
+    FILE* errFile = fdopen(errFd, "r");
+    rewind(errFile);
+    while(fgets(line, sizeof(line), errFile) != NULL && strncmp(line, "warmup1-stats ", 14) != 0){
+    }
+    fclose(errFile);
+    double parse = statsValue(line, "parse_us") / 1e6;
+    double sort = statsValue(line, "sort_us") / 1e6;
+    double print = statsValue(line, "print_us") / 1e6;
+    close(tfileFd);
+    close(nullFd);
+
+    double total = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    fprintf(stdout, "%-10s %10d %10.4f %10.4f %10.4f %10.4f %12.0f %10ld\n", order, gnRows, parse, sort, print, total, gnRows / (total > 0 ? total : 1e-9), peakRSS);
+}
+
+int main(int argc, char *argv[]){
+    ProcessOptions(argc, argv);
+
+    fprintf(stdout, "sort -j %s -a %s\n", gszJobs, gszAlgo);
+    fprintf(stdout, "%-10s %10s %10s %10s %10s %10s %12s %10s\n", "order", "rows", "parse(s)", "sort(s)", "print(s)", "total(s)", "rows/s", "peakKB");
+    runBench("sorted");
+    runBench("reverse");
+    runBench("random");
+    runBench("clustered");
+    return 0;
+}
@@ -8,15 +8,22 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "cs402.h"
 
 #include "my402list.h"
+#include "my402listext.h"
 
 static char gszProgName[MAXPATHLENGTH];
 
 int gnDebug=0;
 int gnSeed=0;
+int gnPool=0;
+int gnIndex=0;
+int gnBlocks=0;
+int gnBench=0;
 
 /* ----------------------- Utility Functions ----------------------- */
 
@@ -25,7 +32,7 @@ void Usage()
 {
     fprintf(stderr,
             "usage: %s %s\n",
-            gszProgName, "[-debug] [-seed=positive_integer]");
+            gszProgName, "[-debug] [-pool] [-index] [-blocks] [-bench[=positive_integer]] [-seed=positive_integer]");
     exit(-1);
 }
 
@@ -36,6 +43,18 @@ void ProcessOptions(int argc, char *argv[])
         if (*argv[0] == '-') {
             if (strcmp(*argv, "-debug") == 0) {
                 gnDebug++;
+            } else if (strcmp(*argv, "-pool") == 0) {
+                gnPool++;
+            } else if (strcmp(*argv, "-index") == 0) {
+                gnIndex++;
+            } else if (strcmp(*argv, "-blocks") == 0) {
+                gnBlocks++;
+            } else if (strcmp(*argv, "-bench") == 0) {
+                gnBench = 1000000;
+            } else if (strncmp(*argv, "-bench=", 7) == 0) {
+                if (sscanf(&(*argv)[7], "%d", &gnBench) != 1 || gnBench <= 0) {
+                    Usage();
+                }
             } else if (strncmp(*argv, "-seed=", 6) == 0) {
                 if (sscanf(&(*argv)[6], "%d", &gnSeed) != 1 || gnSeed <= 0) {
                     Usage();
@@ -96,7 +115,13 @@ void RandomShuffle(My402List *pList, int num_items)
     My402ListElem *elem=NULL;
 
     memset(&list2, 0, sizeof(My402List));
-    (void)My402ListInit(&list2);
+    if (gnPool > 0) {
+        (void)My402ListInitPool(&list2, 0);
+    } else if (gnBlocks > 0) {
+        (void)My402ListInitBlocks(&list2);
+    } else {
+        (void)My402ListInit(&list2);
+    }
 
     for (i=0; i < num_items; i++) {
         int j=0, idx=0, num_in_list=num_items-i;
@@ -316,8 +341,20 @@ void DoTest()
 
     memset(&list, 0, sizeof(My402List));
     memset(&list2, 0, sizeof(My402List));
-    (void)My402ListInit(&list);
-    (void)My402ListInit(&list2);
+    if (gnPool > 0) {
+        (void)My402ListInitPool(&list, 0);
+        (void)My402ListInitPool(&list2, 0);
+    } else if (gnBlocks > 0) {
+        (void)My402ListInitBlocks(&list);
+        (void)My402ListInitBlocks(&list2);
+    } else {
+        (void)My402ListInit(&list);
+        (void)My402ListInit(&list2);
+    }
+    if (gnIndex > 0) {
+        (void)My402ListEnableIndex(&list);
+        (void)My402ListEnableIndex(&list2);
+    }
 
     CreateTestList(&list, num_items);
     printf("create list: \n");
@@ -340,6 +377,454 @@ void DoTest()
 
     My402ListUnlinkAll(&list);
     My402ListUnlinkAll(&list2);
+    My402ListDisableIndex(&list);
+    My402ListDisableIndex(&list2);
+}
+
+/* ----------------------- Bench() ----------------------- */
+
+#define BENCH_PLAIN 0
+#define BENCH_POOL 1
+#define BENCH_BLOCKS 2
+
+/* each obj is a malloc'ed record about the size of a warmup1 transaction */
+#define BENCH_OBJ_BYTES 64
+
+static
+double Seconds(struct timeval *start)
+{
+    struct timeval now;
+
+    (void)gettimeofday(&now, NULL);
+    return (double)(now.tv_sec-start->tv_sec)+((double)(now.tv_usec-start->tv_usec))/1000000.0;
+}
+
+static
+long BenchWalk(My402List *pList, int passes)
+    /* sums obj forward and subtracts it backward, so a good list returns 0 */
+{
+    int i=0;
+    long sum=0;
+    My402ListElem *elem=NULL;
+
+    for (i=0; i < passes; i++) {
+        for (elem=My402ListFirst(pList); elem != NULL; elem=My402ListNext(pList, elem)) {
+            sum += (long)elem->obj;
+        }
+        for (elem=My402ListLast(pList); elem != NULL; elem=My402ListPrev(pList, elem)) {
+            sum -= (long)elem->obj;
+        }
+    }
+    return sum;
+}
+
+static
+void BenchInit(My402List *pList, int backend)
+{
+    memset(pList, 0, sizeof(My402List));
+    if (backend == BENCH_POOL) {
+        (void)My402ListInitPool(pList, 0);
+    } else if (backend == BENCH_BLOCKS) {
+        (void)My402ListInitBlocks(pList);
+    } else {
+        (void)My402ListInit(pList);
+    }
+}
+
+static
+void BenchBackend(char *name, int backend, int num_items)
+    /*
+     * Times building a list by appending, walking it forward and backward,
+     * then random churn: a walk of a random length from the current elem,
+     * unlink there and insert a new elem nearby. Objs are malloc'ed between
+     * appends, as warmup1 does, so the elems of a plain list are spread
+     * out among them. The list is walked again after the churn.
+     */
+{
+    int i=0, passes=10, num_churn=num_items;
+    long sum=0;
+    double build=0, walk=0, churn=0, walk2=0;
+    My402List list;
+    My402ListElem *elem=NULL;
+    struct timeval start;
+
+    BenchInit(&list, backend);
+    (void)gettimeofday(&start, NULL);
+    for (i=0; i < num_items; i++) {
+        (void)My402ListAppend(&list, malloc(BENCH_OBJ_BYTES));
+    }
+    build = Seconds(&start);
+
+    (void)gettimeofday(&start, NULL);
+    sum += BenchWalk(&list, passes);
+    walk = Seconds(&start);
+
+    (void)gettimeofday(&start, NULL);
+    elem = My402ListFirst(&list);
+    for (i=0; i < num_churn; i++) {
+        int j=0, steps=(int)(drand48()*16);
+        My402ListElem *next=NULL;
+
+        for (j=0; j < steps; j++) {
+            elem = My402ListNext(&list, elem);
+            if (elem == NULL) elem = My402ListFirst(&list);
+        }
+        next = My402ListNext(&list, elem);
+        if (next == NULL) next = My402ListFirst(&list);
+        free(elem->obj);
+        My402ListUnlink(&list, elem);
+        if (drand48() < 0.5) {
+            (void)My402ListInsertBefore(&list, malloc(BENCH_OBJ_BYTES), next);
+        } else {
+            (void)My402ListInsertAfter(&list, malloc(BENCH_OBJ_BYTES), next);
+        }
+        elem = next;
+    }
+    churn = Seconds(&start);
+
+    (void)gettimeofday(&start, NULL);
+    sum += BenchWalk(&list, passes);
+    walk2 = Seconds(&start);
+
+    if (sum != 0 || My402ListLength(&list) != num_items) {
+        fprintf(stderr, "%s: bad list after bench\n", name);
+        exit(1);
+    }
+    for (elem=My402ListFirst(&list); elem != NULL; elem=My402ListNext(&list, elem)) {
+        free(elem->obj);
+    }
+    My402ListUnlinkAll(&list);
+
+    printf("%-10s %10d %14.0f %14.0f %14.0f %14.0f\n", name, num_items,
+            num_items/(build > 0 ? build : 1e-9),
+            ((double)passes)*2*num_items/(walk > 0 ? walk : 1e-9),
+            num_churn/(churn > 0 ? churn : 1e-9),
+            ((double)passes)*2*num_items/(walk2 > 0 ? walk2 : 1e-9));
+}
+
+static
+void Bench()
+{
+    printf("%-10s %10s %14s %14s %14s %14s\n", "backend", "items", "append/s", "walk/s", "churn/s", "churnwalk/s");
+    BenchBackend("plain", BENCH_PLAIN, gnBench);
+    BenchBackend("pool", BENCH_POOL, gnBench);
+    BenchBackend("blocks", BENCH_BLOCKS, gnBench);
+}
+
+/* ----------------------- SpliceTest() ----------------------- */
+
+#define SPLICE_ITEMS 64
+#define SPLICE_OPS 200
+
+/* a model of one list: the objs it should hold, in order */
+typedef struct tagSpliceModel {
+    int num_items;
+    int items[SPLICE_ITEMS*4];
+} SpliceModel;
+
+static
+void SpliceInit(My402List *pList, int backend)
+{
+    BenchInit(pList, backend);
+    if (gnIndex > 0) {
+        (void)My402ListEnableIndex(pList);
+    }
+}
+
+static
+void CheckSpliceList(My402List *pList, SpliceModel *pModel, char *where)
+    /* length, both walk directions and Find must all agree with the model */
+{
+    My402ListElem *elem=NULL;
+    int i=0;
+
+    if (My402ListLength(pList) != pModel->num_items || My402ListEmpty(pList) != (pModel->num_items == 0)) {
+        fprintf(stderr, "List length is %1d, not %1d after %s.\n", My402ListLength(pList), pModel->num_items, where);
+        exit(1);
+    }
+    for (elem=My402ListFirst(pList), i=0; elem != NULL; elem=My402ListNext(pList, elem), i++) {
+        if (i >= pModel->num_items || (int)(long)(elem->obj) != pModel->items[i]) {
+            fprintf(stderr, "Item %1d is wrong walking forward after %s.\n", i, where);
+            exit(1);
+        }
+        if (My402ListFind(pList, elem->obj) != elem) {
+            fprintf(stderr, "Cannot find %1d after %s.\n", pModel->items[i], where);
+            exit(1);
+        }
+    }
+    if (i != pModel->num_items) {
+        fprintf(stderr, "Forward walk ends at %1d after %s.\n", i, where);
+        exit(1);
+    }
+    for (elem=My402ListLast(pList), i=pModel->num_items-1; elem != NULL; elem=My402ListPrev(pList, elem), i--) {
+        if (i < 0 || (int)(long)(elem->obj) != pModel->items[i]) {
+            fprintf(stderr, "Item %1d is wrong walking backward after %s.\n", i, where);
+            exit(1);
+        }
+    }
+    if (i != -1) {
+        fprintf(stderr, "Backward walk ends at %1d after %s.\n", i, where);
+        exit(1);
+    }
+}
+
+static
+void CheckNotInList(My402List *pList, SpliceModel *pOther, char *where)
+    /* objs of the other list must not be found, through the index or not */
+{
+    int i=0;
+
+    for (i=0; i < pOther->num_items; i++) {
+        if (My402ListFind(pList, (void*)(long)pOther->items[i]) != NULL) {
+            fprintf(stderr, "%1d is found in the wrong list after %s.\n", pOther->items[i], where);
+            exit(1);
+        }
+    }
+}
+
+static
+My402ListElem *NthElem(My402List *pList, int n)
+{
+    My402ListElem *elem=NULL;
+
+    for (elem=My402ListFirst(pList); elem != NULL && n > 0; elem=My402ListNext(pList, elem)) {
+        n--;
+    }
+    return elem;
+}
+
+static
+void ModelMove(SpliceModel *pDst, int after_obj, SpliceModel *pSrc, int start, int count)
+    /* moves count items of pSrc from start to right after after_obj in pDst, or to its end if after_obj < 0 */
+{
+    int run[SPLICE_ITEMS*4];
+    int i=0, pos=0;
+
+    memcpy(run, &pSrc->items[start], sizeof(int)*count);
+    memmove(&pSrc->items[start], &pSrc->items[start+count], sizeof(int)*(pSrc->num_items-start-count));
+    pSrc->num_items -= count;
+
+    pos = pDst->num_items;
+    if (after_obj >= 0) {
+        for (i=0; i < pDst->num_items; i++) {
+            if (pDst->items[i] == after_obj) {
+                pos = i+1;
+                break;
+            }
+        }
+    }
+    memmove(&pDst->items[pos+count], &pDst->items[pos], sizeof(int)*(pDst->num_items-pos));
+    memcpy(&pDst->items[pos], run, sizeof(int)*count);
+    pDst->num_items += count;
+}
+
+static
+void ModelAppendArray(My402List *pList, SpliceModel *pModel, int *next_obj, int num_items)
+{
+    void *objs[SPLICE_ITEMS];
+    int i=0;
+
+    for (i=0; i < num_items; i++) {
+        objs[i] = (void*)(long)(*next_obj);
+        pModel->items[pModel->num_items++] = (*next_obj)++;
+    }
+    if (!My402ListAppendArray(pList, objs, num_items)) {
+        fprintf(stderr, "My402ListAppendArray() failed.\n");
+        exit(1);
+    }
+}
+
+static
+void SpliceCheckBoth(My402List *pLists, SpliceModel *pModels, char *where)
+{
+    CheckSpliceList(&pLists[0], &pModels[0], where);
+    CheckSpliceList(&pLists[1], &pModels[1], where);
+    CheckNotInList(&pLists[0], &pModels[1], where);
+    CheckNotInList(&pLists[1], &pModels[0], where);
+}
+
+static
+void RandomSplice(My402List *pLists, SpliceModel *pModels, int backend, int *next_obj)
+    /* one random AppendArray, Splice, SplitAt or Concat, checked against the model */
+{
+    int from=RandomIndex(2), to=RandomIndex(2), op=RandomIndex(4);
+    My402List *pSrc=&pLists[from], *pDst=&pLists[to];
+    SpliceModel *pSrcModel=&pModels[from], *pDstModel=&pModels[to];
+    int start=0, count=0;
+
+    if (backend == BENCH_POOL && op != 3) {
+        /* elems cannot leave a pooled list but through Concat; CrossBackendTest() checks the refusal */
+        to = from;
+        pDst = pSrc;
+        pDstModel = pSrcModel;
+        if (op == 2) op = 1;
+    }
+    if (op == 0 || pSrcModel->num_items == 0) {
+        if (pModels[0].num_items+pModels[1].num_items+SPLICE_ITEMS/2 <= SPLICE_ITEMS*4) {
+            ModelAppendArray(pDst, pDstModel, next_obj, RandomIndex(SPLICE_ITEMS/2)+1);
+            SpliceCheckBoth(pLists, pModels, "AppendArray");
+        }
+        return;
+    }
+    if (op == 1) {
+        /* Splice a random run, within one list or across */
+        My402ListElem *first=NULL, *last=NULL, *after=NULL;
+        int after_obj=(-1);
+
+        start = RandomIndex(pSrcModel->num_items);
+        count = RandomIndex(pSrcModel->num_items-start)+1;
+        first = NthElem(pSrc, start);
+        last = NthElem(pSrc, start+count-1);
+        if (from == to) {
+            /* the insertion point must be outside the run */
+            int outside=pSrcModel->num_items-count, pos=RandomIndex(outside+1);
+
+            if (pos < outside) {
+                after = NthElem(pSrc, pos < start ? pos : pos+count);
+                after_obj = (int)(long)(after->obj);
+            }
+        } else if (pDstModel->num_items > 0) {
+            int pos=RandomIndex(pDstModel->num_items+1);
+
+            if (pos < pDstModel->num_items) {
+                after = NthElem(pDst, pos);
+                after_obj = (int)(long)(after->obj);
+            }
+        }
+        if (!My402ListSplice(pDst, after, pSrc, first, last, count)) {
+            fprintf(stderr, "My402ListSplice() failed.\n");
+            exit(1);
+        }
+        ModelMove(pDstModel, after_obj, pSrcModel, start, count);
+        SpliceCheckBoth(pLists, pModels, "Splice");
+    } else if (op == 2) {
+        /* SplitAt into the other list, with the count given or counted */
+        pDst = &pLists[1-from];
+        pDstModel = &pModels[1-from];
+        start = RandomIndex(pSrcModel->num_items);
+        count = pSrcModel->num_items-start;
+        if (!My402ListSplitAt(pSrc, NthElem(pSrc, start), pDst, RandomIndex(2) ? count : (-1))) {
+            fprintf(stderr, "My402ListSplitAt() failed.\n");
+            exit(1);
+        }
+        ModelMove(pDstModel, -1, pSrcModel, start, count);
+        SpliceCheckBoth(pLists, pModels, "SplitAt");
+    } else if (from != to) {
+        if (!My402ListConcat(pDst, pSrc)) {
+            fprintf(stderr, "My402ListConcat() failed.\n");
+            exit(1);
+        }
+        ModelMove(pDstModel, -1, pSrcModel, 0, pSrcModel->num_items);
+        SpliceCheckBoth(pLists, pModels, "Concat");
+    }
+}
+
+static
+int QuietStderr()
+    /* sends stderr to /dev/null, returns the saved descriptor for RestoreStderr() */
+{
+    int saved_fd=(-1), null_fd=(-1);
+
+    fflush(stderr);
+    saved_fd = dup(2);
+    null_fd = open("/dev/null", O_WRONLY);
+    if (saved_fd < 0 || null_fd < 0 || dup2(null_fd, 2) < 0) {
+        fprintf(stderr, "Cannot redirect stderr.\n");
+        exit(1);
+    }
+    close(null_fd);
+    return saved_fd;
+}
+
+static
+void RestoreStderr(int saved_fd)
+{
+    fflush(stderr);
+    dup2(saved_fd, 2);
+    close(saved_fd);
+}
+
+static
+void RefusedSplice(int backend, int other_backend)
+    /* every move between these two lists must fail and leave both alone */
+{
+    My402List lists[2];
+    SpliceModel models[2];
+    int next_obj=0, saved_fd=(-1), moved=FALSE;
+
+    memset(models, 0, sizeof(models));
+    SpliceInit(&lists[0], backend);
+    SpliceInit(&lists[1], other_backend);
+    ModelAppendArray(&lists[0], &models[0], &next_obj, SPLICE_ITEMS/2);
+    ModelAppendArray(&lists[1], &models[1], &next_obj, SPLICE_ITEMS/2);
+
+    /* the library explains each refusal on stderr; only the return values matter here */
+    saved_fd = QuietStderr();
+    moved = My402ListSplice(&lists[1], NULL, &lists[0], NthElem(&lists[0], 1), NthElem(&lists[0], 3), 3) ||
+            My402ListSplice(&lists[0], My402ListFirst(&lists[0]), &lists[1], My402ListFirst(&lists[1]), My402ListLast(&lists[1]), SPLICE_ITEMS/2) ||
+            (backend != other_backend && My402ListConcat(&lists[0], &lists[1])) ||
+            (backend != other_backend && My402ListConcat(&lists[1], &lists[0])) ||
+            My402ListSplitAt(&lists[0], NthElem(&lists[0], 5), &lists[1], -1) ||
+            My402ListSplitAt(&lists[1], My402ListFirst(&lists[1]), &lists[0], SPLICE_ITEMS/2);
+    RestoreStderr(saved_fd);
+    if (moved) {
+        fprintf(stderr, "A move between backends %1d and %1d did not fail.\n", backend, other_backend);
+        exit(1);
+    }
+    SpliceCheckBoth(lists, models, "a refused move");
+
+    My402ListUnlinkAll(&lists[0]);
+    My402ListUnlinkAll(&lists[1]);
+    My402ListDisableIndex(&lists[0]);
+    My402ListDisableIndex(&lists[1]);
+}
+
+static
+void SpliceTest()
+{
+    int backend=BENCH_PLAIN, i=0, next_obj=0;
+    My402List lists[2];
+    SpliceModel models[2];
+
+    if (gnPool > 0) {
+        backend = BENCH_POOL;
+    } else if (gnBlocks > 0) {
+        backend = BENCH_BLOCKS;
+    }
+    memset(models, 0, sizeof(models));
+    SpliceInit(&lists[0], backend);
+    SpliceInit(&lists[1], backend);
+    ModelAppendArray(&lists[0], &models[0], &next_obj, SPLICE_ITEMS);
+    SpliceCheckBoth(lists, models, "AppendArray");
+
+    for (i=0; i < SPLICE_OPS; i++) {
+        RandomSplice(lists, models, backend, &next_obj);
+    }
+    printf("splice list: \n");
+    if (gnDebug > 0) {
+        PrintTestList(&lists[0], models[0].num_items);
+        PrintTestList(&lists[1], models[1].num_items);
+    }
+    My402ListUnlinkAll(&lists[0]);
+    My402ListUnlinkAll(&lists[1]);
+    My402ListDisableIndex(&lists[0]);
+    My402ListDisableIndex(&lists[1]);
+}
+
+static
+void CrossBackendTest()
+    /* Splice, SplitAt and Concat refuse to mix backends, and Splice and SplitAt to move between pools */
+{
+    int backend=0, other_backend=0;
+
+    for (backend=BENCH_PLAIN; backend <= BENCH_BLOCKS; backend++) {
+        for (other_backend=BENCH_PLAIN; other_backend <= BENCH_BLOCKS; other_backend++) {
+            if (other_backend != backend || backend == BENCH_POOL) {
+                RefusedSplice(backend, other_backend);
+            }
+        }
+    }
+    printf("refuse splice across backends: \n");
 }
 
 /* ----------------------- Process() ----------------------- */
@@ -357,9 +842,15 @@ void Process()
         (void)gettimeofday(&tv, NULL);
         srand48(((long)tv.tv_sec)+((long)tv.tv_usec));
     }
+    if (gnBench > 0) {
+        Bench();
+        return;
+    }
     for (i=0; i < num_itr; i++) {
         DoTest();
+        SpliceTest();
     }
+    CrossBackendTest();
 }
 
 /* ----------------------- main() ----------------------- */
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "my402date.h"
+
+void My402DateInit(My402DateCache* cache){
+    cache->start = 0;
+    cache->end = 0;
+    memset(cache->str, 0, sizeof(cache->str));
+}
+
+static int sameLocalDay(long timestamp, struct tm* day){
+    time_t t = (time_t)timestamp;
+    struct tm other;
+    localtime_r(&t, &other);
+    return other.tm_year == day->tm_year && other.tm_yday == day->tm_yday && other.tm_gmtoff == day->tm_gmtoff;
+}
+
+/*
+ * Returns the date string for timestamp; it stays valid until the next call
+ * with the same cache. On a miss the whole local day around timestamp is
+ * cached, unless the UTC offset changes during that day (a DST switch), in
+ * which case only this one timestamp is.
+ */
+const char *My402DateFormat(My402DateCache* cache, long timestamp){
+    if(timestamp >= cache->start && timestamp < cache->end){
+        return cache->str;
+    }
+    time_t t = (time_t)timestamp;
+    struct tm timeInfo;
+    localtime_r(&t, &timeInfo);
+    strftime(cache->str, sizeof(cache->str), "%a %b %d %Y", &timeInfo);
+    if(cache->str[8] == '0'){
+        cache->str[8] = ' ';
+    }
+
+    long start = timestamp - (timeInfo.tm_hour * 3600 + timeInfo.tm_min * 60 + timeInfo.tm_sec);
+    long end = start + 24 * 3600;
+    if(sameLocalDay(start, &timeInfo) && sameLocalDay(end - 1, &timeInfo) && !sameLocalDay(end, &timeInfo)){
+        cache->start = start;
+        cache->end = end;
+    }
+    else{
+        cache->start = timestamp;
+        cache->end = timestamp + 1;
+    }
+    return cache->str;
+}
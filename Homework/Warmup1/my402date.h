@@ -0,0 +1,19 @@
+#ifndef _MY402DATE_H_
+#define _MY402DATE_H_
+
+/*
+ * Formats timestamps as the 15-char "Thu Aug 21 2008" date column. The
+ * cache remembers the local day of the last timestamp, so a run of
+ * timestamps from the same day (as in a sorted list) costs one localtime
+ * call per day instead of one per row.
+ */
+typedef struct tagMy402DateCache {
+    long start;
+    long end;
+    char str[16];
+} My402DateCache;
+
+extern void My402DateInit(My402DateCache*);
+extern const char *My402DateFormat(My402DateCache*, long);
+
+#endif /*_MY402DATE_H_*/
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "my402input.h"
+
+#define INPUT_BLOCK_SIZE (1 << 20)
+
+int My402InputOpen(My402Input* input, int fd){
+    memset(input, 0, sizeof(My402Input));
+    input->fd = fd;
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0){
+        void* data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data != MAP_FAILED){
+            madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+            input->mapped = TRUE;
+            input->eof = TRUE;
+            input->data = (char*)data;
+            input->size = fileStat.st_size;
+            return TRUE;
+        }
+    }
+
+    return My402InputOpenStream(input, fd);
+}
+
+/* reads in blocks even if fd is a regular file, so a huge input is never mapped */
+int My402InputOpenStream(My402Input* input, int fd){
+    memset(input, 0, sizeof(My402Input));
+    input->fd = fd;
+    input->capacity = INPUT_BLOCK_SIZE;
+    input->data = (char*)malloc(input->capacity);
+    if(input->data == NULL){
+        fprintf(stderr, "Error malloc in input.\n");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static int clampLineLen(long long len){
+    return len > 0x7fffffffLL ? 0x7fffffff : (int)len;
+}
+
+/* move the unread tail to the front of the buffer and read another block */
+static int fillBlock(My402Input* input){
+    if(input->eof){
+        return FALSE;
+    }
+    long long remain = input->size - input->pos;
+    if(remain > 0 && input->pos > 0){
+        memmove(input->data, input->data + input->pos, remain);
+    }
+    input->size = remain;
+    input->pos = 0;
+    while(input->size < input->capacity){
+        ssize_t readSize = read(input->fd, input->data + input->size, input->capacity - input->size);
+        if(readSize <= 0){
+            input->eof = TRUE;
+            break;
+        }
+        input->size += readSize;
+        if(memchr(input->data + input->size - readSize, '\n', readSize) != NULL){
+            break;
+        }
+    }
+    return input->size > remain;
+}
+
+int My402InputNextLine(My402Input* input, char** line, int* lineLen){
+    while(TRUE){
+        char* start = input->data + input->pos;
+        long long remain = input->size - input->pos;
+        char* newline = remain > 0 ? (char*)memchr(start, '\n', remain) : NULL;
+        if(newline != NULL){
+            *line = start;
+            *lineLen = clampLineLen(newline - start + 1);
+            input->pos += newline - start + 1;
+            return TRUE;
+        }
+        if(remain >= input->capacity && !input->mapped){
+            /* no newline in a full block, so the line is far too long anyway */
+            *line = start;
+            *lineLen = clampLineLen(remain);
+            input->pos += remain;
+            return TRUE;
+        }
+        if(!fillBlock(input)){
+            if(remain <= 0){
+                return FALSE;
+            }
+            *line = input->data + input->pos;
+            *lineLen = clampLineLen(input->size - input->pos);
+            input->pos = input->size;
+            return TRUE;
+        }
+    }
+}
+
+/*
+ * Makes data[pos, size) hold the rest of the input. Already true for a
+ * mapped file; a pipe is read to the end, growing the buffer as needed.
+ */
+int My402InputReadAll(My402Input* input){
+    if(input->mapped){
+        return TRUE;
+    }
+    while(!input->eof){
+        if(input->size == input->capacity){
+            char* data = (char*)realloc(input->data, input->capacity * 2);
+            if(data == NULL){
+                fprintf(stderr, "Error malloc in input.\n");
+                return FALSE;
+            }
+            input->data = data;
+            input->capacity *= 2;
+        }
+        ssize_t readSize = read(input->fd, input->data + input->size, input->capacity - input->size);
+        if(readSize <= 0){
+            input->eof = TRUE;
+            break;
+        }
+        input->size += readSize;
+    }
+    return TRUE;
+}
+
+void My402InputClose(My402Input* input){
+    if(input->mapped){
+        munmap(input->data, input->size);
+    }
+    else{
+        free(input->data);
+    }
+    input->data = NULL;
+}
@@ -0,0 +1,27 @@
+#ifndef _MY402INPUT_H_
+#define _MY402INPUT_H_
+
+#include "cs402.h"
+
+/*
+ * Line reader for tfiles. A regular file is mmap'ed and lines are handed
+ * out in place; anything else (a pipe on stdin) is read in large blocks.
+ * A line is returned with its trailing '\n', if it has one.
+ */
+typedef struct tagMy402Input {
+    int fd;
+    int mapped;
+    int eof;
+    char *data;
+    long long size;
+    long long pos;
+    long long capacity;
+} My402Input;
+
+extern int  My402InputOpen(My402Input*, int);
+extern int  My402InputOpenStream(My402Input*, int);
+extern int  My402InputNextLine(My402Input*, char**, int*);
+extern int  My402InputReadAll(My402Input*);
+extern void My402InputClose(My402Input*);
+
+#endif /*_MY402INPUT_H_*/
@@ -0,0 +1,514 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "my402ledger.h"
+
+void My402LedgerInit(My402Ledger* ledger){
+    memset(ledger, 0, sizeof(My402Ledger));
+}
+
+static int growRows(My402Ledger* ledger, int capacity){
+    unsigned int* timestamp = (unsigned int*)realloc(ledger->timestamp, sizeof(unsigned int) * capacity);
+    if(timestamp != NULL){
+        ledger->timestamp = timestamp;
+    }
+    int* amount = (int*)realloc(ledger->amount, sizeof(int) * capacity);
+    if(amount != NULL){
+        ledger->amount = amount;
+    }
+    int* lineNum = (int*)realloc(ledger->lineNum, sizeof(int) * capacity);
+    if(lineNum != NULL){
+        ledger->lineNum = lineNum;
+    }
+    long long* descOffset = (long long*)realloc(ledger->descOffset, sizeof(long long) * capacity);
+    if(descOffset != NULL){
+        ledger->descOffset = descOffset;
+    }
+    if(timestamp == NULL || amount == NULL || lineNum == NULL || descOffset == NULL){
+        return FALSE;
+    }
+    ledger->capacity = capacity;
+    return TRUE;
+}
+
+static int growArena(My402Ledger* ledger, long long capacity){
+    char* arena = (char*)realloc(ledger->arena, capacity);
+    if(arena == NULL){
+        return FALSE;
+    }
+    ledger->arena = arena;
+    ledger->arena_capacity = capacity;
+    return TRUE;
+}
+
+/* desc is copied into the arena, descLen chars plus a '\0' */
+int My402LedgerAppend(My402Ledger* ledger, unsigned int timestamp, int amount, int lineNum, const char* desc, int descLen){
+    if(ledger->num_rows == ledger->capacity && !growRows(ledger, ledger->capacity > 0 ? ledger->capacity * 2 : 1024)){
+        return FALSE;
+    }
+    if(ledger->arena_used + descLen + 1 > ledger->arena_capacity){
+        long long capacity = ledger->arena_capacity > 0 ? ledger->arena_capacity : 16384;
+        while(capacity < ledger->arena_used + descLen + 1){
+            capacity *= 2;
+        }
+        if(!growArena(ledger, capacity)){
+            return FALSE;
+        }
+    }
+    int row = ledger->num_rows;
+    ledger->timestamp[row] = timestamp;
+    ledger->amount[row] = amount;
+    ledger->lineNum[row] = lineNum;
+    ledger->descOffset[row] = ledger->arena_used;
+    memcpy(ledger->arena + ledger->arena_used, desc, descLen);
+    ledger->arena[ledger->arena_used + descLen] = '\0';
+    ledger->arena_used += descLen + 1;
+    ledger->num_rows++;
+    return TRUE;
+}
+
+/* appends a copy of row of src */
+int My402LedgerAppendRow(My402Ledger* ledger, My402Ledger* src, int row){
+    const char* desc = My402LedgerDesc(src, row);
+    return My402LedgerAppend(ledger, src->timestamp[row], src->amount[row], src->lineNum[row], desc, strlen(desc));
+}
+
+/* makes room for rows more rows and arenaBytes more description bytes */
+int My402LedgerReserve(My402Ledger* ledger, int rows, long long arenaBytes){
+    if(ledger->num_rows + rows > ledger->capacity && !growRows(ledger, ledger->num_rows + rows)){
+        return FALSE;
+    }
+    if(ledger->arena_used + arenaBytes > ledger->arena_capacity && !growArena(ledger, ledger->arena_used + arenaBytes)){
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* drops all rows but keeps the memory */
+void My402LedgerClear(My402Ledger* ledger){
+    ledger->num_rows = 0;
+    ledger->arena_used = 0;
+}
+
+void My402LedgerFree(My402Ledger* ledger){
+    free(ledger->timestamp);
+    free(ledger->amount);
+    free(ledger->lineNum);
+    free(ledger->descOffset);
+    free(ledger->arena);
+    My402LedgerInit(ledger);
+}
+
+static int writeAll(FILE* file, const void* data, long long size){
+    return size == 0 || fwrite(data, size, 1, file) == 1;
+}
+
+static void fillHeader(My402LedgerFileHeader* header, long long numRows){
+    memset(header, 0, sizeof(My402LedgerFileHeader));
+    memcpy(header->magic, LEDGER_FILE_MAGIC, sizeof(header->magic));
+    header->version = LEDGER_FILE_VERSION;
+    header->row_size = sizeof(My402LedgerRow);
+    header->num_rows = numRows;
+    header->index_stride = LEDGER_INDEX_STRIDE;
+    header->num_index = (numRows + LEDGER_INDEX_STRIDE - 1) / LEDGER_INDEX_STRIDE;
+    header->rows_offset = sizeof(My402LedgerFileHeader);
+    header->index_offset = header->rows_offset + (long long)sizeof(My402LedgerRow) * numRows;
+}
+
+static FILE* openTempFile(const char* path, char* tempPath, int tempPathSize){
+    if(snprintf(tempPath, tempPathSize, "%s.tmp", path) >= tempPathSize){
+        fprintf(stderr, "Ledger file name %s is too long.\n", path);
+        return NULL;
+    }
+    FILE* file = fopen(tempPath, "w");
+    if(file == NULL){
+        fprintf(stderr, "Error opening file %s.\n", tempPath);
+    }
+    return file;
+}
+
+/* syncs the temp file and renames it over path, or removes it on failure */
+static int replaceWithTempFile(FILE* file, const char* tempPath, const char* path, int ok){
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if(fclose(file) != 0 || !ok || rename(tempPath, path) != 0){
+        fprintf(stderr, "Error writing ledger file %s.\n", path);
+        unlink(tempPath);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static int validHeader(const My402LedgerFileHeader* header, long long size){
+    return memcmp(header->magic, LEDGER_FILE_MAGIC, sizeof(header->magic)) == 0 && header->version == LEDGER_FILE_VERSION &&
+           header->row_size == sizeof(My402LedgerRow) && header->index_stride == LEDGER_INDEX_STRIDE && header->num_rows >= 0 &&
+           header->num_index == (header->num_rows + LEDGER_INDEX_STRIDE - 1) / LEDGER_INDEX_STRIDE &&
+           header->rows_offset == sizeof(My402LedgerFileHeader) &&
+           header->index_offset == header->rows_offset + (long long)sizeof(My402LedgerRow) * header->num_rows &&
+           header->index_offset + (long long)sizeof(unsigned int) * header->num_index == size;
+}
+
+#define LEDGER_JOURNAL_MAGIC "W1JOURNL"
+
+/*
+ * What an append changes in a ledger file: the new header, and size bytes
+ * that go at offset, where the file then ends. The bytes follow it in
+ * path.journal.
+ */
+typedef struct tagLedgerJournal {
+    char magic[8];
+    long long offset;
+    long long size;
+    My402LedgerFileHeader header;
+} LedgerJournal;
+
+static int journalPathOf(const char* path, char* journalPath, int journalPathSize){
+    if(snprintf(journalPath, journalPathSize, "%s.journal", path) >= journalPathSize){
+        fprintf(stderr, "Ledger file name %s is too long.\n", path);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* syncs the directory path is in, so a rename or unlink there is on disk */
+static int syncDirOf(const char* path){
+    char dir[MAXPATHLENGTH + 16];
+    const char* slash = strrchr(path, '/');
+    if(slash == NULL){
+        strcpy(dir, ".");
+    }
+    else if(slash == path){
+        strcpy(dir, "/");
+    }
+    else if(slash - path < (long long)sizeof(dir)){
+        memcpy(dir, path, slash - path);
+        dir[slash - path] = '\0';
+    }
+    else{
+        return FALSE;
+    }
+    int fd = open(dir, O_RDONLY);
+    if(fd < 0){
+        return FALSE;
+    }
+    int ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+static int pwriteAll(int fd, const char* data, long long size, long long offset){
+    while(size > 0){
+        ssize_t written = pwrite(fd, data, min(size, 1LL << 30), offset);
+        if(written <= 0){
+            return FALSE;
+        }
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return TRUE;
+}
+
+/* writes the changes of journal into the ledger file at fd and syncs it */
+static int applyJournal(int fd, const LedgerJournal* journal, const char* data){
+    return pwriteAll(fd, data, journal->size, journal->offset) &&
+           pwriteAll(fd, (const char*)&journal->header, sizeof(My402LedgerFileHeader), 0) &&
+           ftruncate(fd, journal->offset + journal->size) == 0 && fsync(fd) == 0;
+}
+
+/* removes path.journal once a new file or the journal's changes are on disk */
+static int dropJournal(const char* journalPath){
+    if(unlink(journalPath) != 0){
+        return errno == ENOENT;
+    }
+    return syncDirOf(journalPath);
+}
+
+/*
+ * Saves the changes of an append in path.journal, synced and renamed into
+ * place, then makes them in the ledger file at fd and removes the journal.
+ * A crash before the rename leaves the old ledger and one after it leaves
+ * the journal for the next open to replay; replaying twice does no harm.
+ */
+static int writeThroughJournal(const char* path, int fd, LedgerJournal* journal, const char* data){
+    char journalPath[MAXPATHLENGTH + 16];
+    char tempPath[MAXPATHLENGTH + 24];
+    if(!journalPathOf(path, journalPath, sizeof(journalPath))){
+        return FALSE;
+    }
+    FILE* file = openTempFile(journalPath, tempPath, sizeof(tempPath));
+    if(file == NULL){
+        return FALSE;
+    }
+    int ok = writeAll(file, journal, sizeof(LedgerJournal)) && writeAll(file, data, journal->size);
+    if(!replaceWithTempFile(file, tempPath, journalPath, ok)){
+        return FALSE;
+    }
+    if(!syncDirOf(journalPath) || !applyJournal(fd, journal, data) || !dropJournal(journalPath)){
+        fprintf(stderr, "Error writing ledger file %s.\n", path);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* replays path.journal if an append crashed after writing it; the caller holds LOCK_EX on path */
+static int recoverJournal(const char* path, const char* journalPath){
+    FILE* file = fopen(journalPath, "r");
+    if(file == NULL){
+        return errno == ENOENT;
+    }
+    LedgerJournal journal;
+    char* data = NULL;
+    int ok = fread(&journal, sizeof(journal), 1, file) == 1 &&
+             memcmp(journal.magic, LEDGER_JOURNAL_MAGIC, sizeof(journal.magic)) == 0 &&
+             journal.offset >= (long long)sizeof(My402LedgerFileHeader) && journal.size >= 0 &&
+             validHeader(&journal.header, journal.offset + journal.size) &&
+             (data = (char*)malloc(max(journal.size, 1))) != NULL &&
+             (journal.size == 0 || fread(data, journal.size, 1, file) == 1);
+    fclose(file);
+    int fd = ok ? open(path, O_WRONLY) : -1;
+    ok = fd >= 0 && applyJournal(fd, &journal, data);
+    if(fd >= 0){
+        close(fd);
+    }
+    free(data);
+    if(!ok || !dropJournal(journalPath)){
+        fprintf(stderr, "Cannot finish the append to %s saved in %s.\n", path, journalPath);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* takes lock (LOCK_SH or LOCK_EX) on the ledger at fd, replaying a journal left by a crash first */
+static int lockLedger(const char* path, int fd, int lock){
+    char journalPath[MAXPATHLENGTH + 16];
+    if(!journalPathOf(path, journalPath, sizeof(journalPath))){
+        return FALSE;
+    }
+    if(flock(fd, lock) != 0){
+        fprintf(stderr, "Error locking file %s.\n", path);
+        return FALSE;
+    }
+    if(access(journalPath, F_OK) != 0){
+        return TRUE;
+    }
+    if(flock(fd, LOCK_EX) != 0 || !recoverJournal(path, journalPath) || flock(fd, lock) != 0){
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Writes a sorted ledger as a compiled ledger file. It goes to path.tmp
+ * first and is renamed over path, so a reader never sees half a file. A
+ * journal of the file it replaces is dropped first so it is never replayed
+ * over the new one.
+ */
+int My402LedgerWriteFile(My402Ledger* ledger, const char* path){
+    char tempPath[MAXPATHLENGTH + 8];
+    char journalPath[MAXPATHLENGTH + 16];
+    if(!journalPathOf(path, journalPath, sizeof(journalPath))){
+        return FALSE;
+    }
+    FILE* file = openTempFile(path, tempPath, sizeof(tempPath));
+    if(file == NULL){
+        return FALSE;
+    }
+
+    My402LedgerFileHeader header;
+    fillHeader(&header, ledger->num_rows);
+
+    int ok = writeAll(file, &header, sizeof(header));
+    long long balance = 0;
+    for(int a = 0; ok && a < ledger->num_rows; a++){
+        My402LedgerRow row;
+        memset(&row, 0, sizeof(row));
+        balance += ledger->amount[a];
+        row.balance = balance;
+        row.timestamp = ledger->timestamp[a];
+        row.amount = ledger->amount[a];
+        row.lineNum = ledger->lineNum[a];
+        strncpy(row.desc, My402LedgerDesc(ledger, a), sizeof(row.desc) - 1);
+        ok = writeAll(file, &row, sizeof(row));
+    }
+    for(unsigned int a = 0; ok && a < header.num_index; a++){
+        ok = writeAll(file, &ledger->timestamp[(long long)a * LEDGER_INDEX_STRIDE], sizeof(unsigned int));
+    }
+    return replaceWithTempFile(file, tempPath, path, ok && dropJournal(journalPath));
+}
+
+/* TRUE if path starts with a compiled ledger header */
+int My402LedgerFileCheck(const char* path){
+    My402LedgerFileHeader header;
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        return FALSE;
+    }
+    int ok = read(fd, &header, sizeof(header)) == sizeof(header) && memcmp(header.magic, LEDGER_FILE_MAGIC, sizeof(header.magic)) == 0;
+    close(fd);
+    return ok;
+}
+
+/* maps the ledger at path, holding LOCK_EX on it for an append and LOCK_SH otherwise until it is closed */
+static int openLedgerFile(My402LedgerFile* ledgerFile, const char* path, int forAppend){
+    memset(ledgerFile, 0, sizeof(My402LedgerFile));
+    int fd = open(path, forAppend ? O_RDWR : O_RDONLY);
+    if(fd < 0){
+        fprintf(stderr, "Error opening file %s.\n", path);
+        return FALSE;
+    }
+    if(!lockLedger(path, fd, forAppend ? LOCK_EX : LOCK_SH)){
+        close(fd);
+        return FALSE;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(My402LedgerFileHeader)){
+        fprintf(stderr, "%s is not a ledger file.\n", path);
+        close(fd);
+        return FALSE;
+    }
+    void* map = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED){
+        fprintf(stderr, "Error reading file %s.\n", path);
+        close(fd);
+        return FALSE;
+    }
+
+    const My402LedgerFileHeader* header = (const My402LedgerFileHeader*)map;
+    long long size = fileStat.st_size;
+    if(!validHeader(header, size)){
+        fprintf(stderr, "%s is not a ledger file.\n", path);
+        munmap(map, size);
+        close(fd);
+        return FALSE;
+    }
+    ledgerFile->fd = fd;
+    ledgerFile->map = map;
+    ledgerFile->size = size;
+    ledgerFile->num_rows = header->num_rows;
+    ledgerFile->num_index = header->num_index;
+    ledgerFile->index_stride = header->index_stride;
+    ledgerFile->index = (const unsigned int*)((const char*)map + header->index_offset);
+    ledgerFile->rows = (const My402LedgerRow*)((const char*)map + header->rows_offset);
+    madvise(map, size, MADV_RANDOM);
+    return TRUE;
+}
+
+int My402LedgerFileOpen(My402LedgerFile* ledgerFile, const char* path){
+    return openLedgerFile(ledgerFile, path, FALSE);
+}
+
+/*
+ * Index of the first row with a timestamp >= timestamp, or num_rows. The
+ * sparse index narrows the search to one stride of rows, so only a few
+ * pages of the row area are touched.
+ */
+long long My402LedgerFileLowerBound(My402LedgerFile* ledgerFile, unsigned int timestamp){
+    long long low = 0, high = ledgerFile->num_index;
+    while(low < high){
+        long long mid = (low + high) / 2;
+        if(ledgerFile->index[mid] < timestamp){
+            low = mid + 1;
+        }
+        else{
+            high = mid;
+        }
+    }
+    long long block = low;
+    low = block > 0 ? (block - 1) * ledgerFile->index_stride : 0;
+    high = min(block * ledgerFile->index_stride, ledgerFile->num_rows);
+    while(low < high){
+        long long mid = (low + high) / 2;
+        if(ledgerFile->rows[mid].timestamp < timestamp){
+            low = mid + 1;
+        }
+        else{
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void My402LedgerFileClose(My402LedgerFile* ledgerFile){
+    if(ledgerFile->map != NULL){
+        munmap(ledgerFile->map, ledgerFile->size);
+        close(ledgerFile->fd);
+    }
+    memset(ledgerFile, 0, sizeof(My402LedgerFile));
+}
+
+static void rowFromLedger(My402LedgerRow* row, My402Ledger* ledger, int a){
+    memset(row, 0, sizeof(My402LedgerRow));
+    row->timestamp = ledger->timestamp[a];
+    row->amount = ledger->amount[a];
+    row->lineNum = ledger->lineNum[a];
+    strncpy(row->desc, My402LedgerDesc(ledger, a), sizeof(row->desc) - 1);
+}
+
+/*
+ * Merges delta, already sorted on timestamp, into the compiled ledger at
+ * path. Only the rows from the first one the delta affects on are merged
+ * and get new balances; the rows before it stay where they are and are
+ * not read. The merged rows, the index and the header are written over the
+ * file through writeThroughJournal(), so a crash leaves either the old
+ * ledger or one the next open completes. A duplicate timestamp is reported
+ * before anything is written.
+ */
+int My402LedgerFileAppend(const char* path, My402Ledger* delta){
+    My402LedgerFile ledgerFile;
+    if(!openLedgerFile(&ledgerFile, path, TRUE)){
+        return FALSE;
+    }
+    long long oldRows = ledgerFile.num_rows;
+    long long first = delta->num_rows > 0 ? My402LedgerFileLowerBound(&ledgerFile, delta->timestamp[0]) : oldRows;
+    long long numMerged = oldRows - first + delta->num_rows;
+
+    LedgerJournal journal;
+    memset(&journal, 0, sizeof(journal));
+    memcpy(journal.magic, LEDGER_JOURNAL_MAGIC, sizeof(journal.magic));
+    fillHeader(&journal.header, oldRows + delta->num_rows);
+    journal.offset = journal.header.rows_offset + (long long)sizeof(My402LedgerRow) * first;
+    journal.size = (long long)sizeof(My402LedgerRow) * numMerged + (long long)sizeof(unsigned int) * journal.header.num_index;
+
+    /* the merged rows and then the index, as they follow each other in the file */
+    char* data = (char*)malloc(max(journal.size, 1));
+    if(data == NULL){
+        fprintf(stderr, "Error malloc in My402LedgerFileAppend().\n");
+        exit(1);
+    }
+    My402LedgerRow* merged = (My402LedgerRow*)data;
+    unsigned int* index = (unsigned int*)(data + sizeof(My402LedgerRow) * numMerged);
+
+    long long balance = first > 0 ? ledgerFile.rows[first - 1].balance : 0;
+    long long oldPos = first;
+    int deltaPos = 0;
+    for(long long a = 0; a < numMerged; a++){
+        if(deltaPos >= delta->num_rows || (oldPos < oldRows && ledgerFile.rows[oldPos].timestamp <= delta->timestamp[deltaPos])){
+            merged[a] = ledgerFile.rows[oldPos++];
+        }
+        else{
+            rowFromLedger(&merged[a], delta, deltaPos++);
+        }
+        if(a > 0 && merged[a].timestamp == merged[a - 1].timestamp){
+            fprintf(stderr, "line%d and %d, field: time, there are two identical timestamps.\n", merged[a - 1].lineNum, merged[a].lineNum);
+            exit(1);
+        }
+        balance += merged[a].amount;
+        merged[a].balance = balance;
+    }
+    for(unsigned int a = 0; a < journal.header.num_index; a++){
+        long long row = (long long)a * LEDGER_INDEX_STRIDE;
+        index[a] = row < first ? ledgerFile.index[a] : merged[row - first].timestamp;
+    }
+
+    int ok = writeThroughJournal(path, ledgerFile.fd, &journal, data);
+    My402LedgerFileClose(&ledgerFile);
+    free(data);
+    return ok;
+}
@@ -0,0 +1,84 @@
+#ifndef _MY402LEDGER_H_
+#define _MY402LEDGER_H_
+
+#include "cs402.h"
+
+/*
+ * Transactions stored column by column: row a is timestamp[a], amount[a]
+ * (in cents, negative for a withdrawal), lineNum[a] and the '\0'-terminated
+ * description at arena + descOffset[a]. A row takes 20 bytes plus its
+ * description, and there is no malloc per row.
+ */
+typedef struct tagMy402Ledger {
+    int num_rows;
+    int capacity;
+    unsigned int *timestamp;
+    int *amount;
+    int *lineNum;
+    long long *descOffset;
+    char *arena;
+    long long arena_used;
+    long long arena_capacity;
+} My402Ledger;
+
+#define My402LedgerDesc(ledger, row) ((ledger)->arena + (ledger)->descOffset[row])
+
+/*
+ * Compiled ledger file: a header, the rows sorted on timestamp, each with
+ * the running balance up to and including itself, then a sparse index
+ * holding the timestamp of every LEDGER_INDEX_STRIDE-th row. The index comes
+ * last so rows can be appended without moving the others. Integers are in
+ * host byte order. An append rewrites the file in place from the first row
+ * it changes on, after saving those bytes in path.journal, which the next
+ * open replays if the append crashed. An open ledger holds a shared flock()
+ * and an append an exclusive one.
+ */
+#define LEDGER_FILE_MAGIC "W1LEDGER"
+#define LEDGER_FILE_VERSION 2
+#define LEDGER_INDEX_STRIDE 1024
+
+typedef struct tagMy402LedgerFileHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int row_size;
+    long long num_rows;
+    unsigned int index_stride;
+    unsigned int num_index;
+    long long index_offset;
+    long long rows_offset;
+} My402LedgerFileHeader;
+
+typedef struct tagMy402LedgerRow {
+    long long balance;
+    unsigned int timestamp;
+    int amount;
+    int lineNum;
+    char desc[28];
+} My402LedgerRow;
+
+typedef struct tagMy402LedgerFile {
+    int fd;
+    void *map;
+    long long size;
+    long long num_rows;
+    unsigned int num_index;
+    unsigned int index_stride;
+    const unsigned int *index;
+    const My402LedgerRow *rows;
+} My402LedgerFile;
+
+extern void My402LedgerInit(My402Ledger*);
+extern int  My402LedgerAppend(My402Ledger*, unsigned int, int, int, const char*, int);
+extern int  My402LedgerAppendRow(My402Ledger*, My402Ledger*, int);
+extern int  My402LedgerReserve(My402Ledger*, int, long long);
+extern void My402LedgerClear(My402Ledger*);
+extern void My402LedgerFree(My402Ledger*);
+
+extern int  My402LedgerWriteFile(My402Ledger*, const char*);
+extern int  My402LedgerFileCheck(const char*);
+extern int  My402LedgerFileOpen(My402LedgerFile*, const char*);
+extern int  My402LedgerFileAppend(const char*, My402Ledger*);
+extern long long My402LedgerFileLowerBound(My402LedgerFile*, unsigned int);
+extern void My402LedgerFileClose(My402LedgerFile*);
+
+#endif /*_MY402LEDGER_H_*/
@@ -4,6 +4,353 @@
 
 #include "my402list.h"
 
+/*
+ * The options and bulk moves below are declared in my402listext.h for
+ * their callers. It is not included here, so this file still builds with
+ * nothing but the stock cs402.h and my402list.h next to it.
+ */
+
+#define DEFAULT_POOL_CHUNK_SIZE 1024
+#define DEFAULT_INDEX_CAPACITY 16
+#define DEFAULT_EXT_BUCKETS 64
+
+typedef struct tagMy402ListChunk {
+    struct tagMy402ListChunk *next;
+    int num_used;
+    int capacity;
+    My402ListElem elems[];
+} My402ListChunk;
+
+#define MY402LIST_BLOCK_ELEMS 16
+
+/*
+ * A block of the block allocator. Neighbouring elems are placed in the
+ * same block where there is room, so they tend to share cache lines, but a
+ * walk still follows next one elem at a time. used has bit a set while
+ * elems[a] is in a list; elems never move, so elem pointers stay valid.
+ */
+typedef struct tagMy402ListBlock {
+    unsigned int used;
+    My402ListElem elems[MY402LIST_BLOCK_ELEMS];
+} My402ListBlock;
+
+/*
+ * The options of one list. The stock My402List has no room for them, so
+ * they live in a side table keyed by the list's address; a plain list has
+ * no entry and reads plainExt, which is all zeros and never written.
+ */
+typedef struct tagMy402ListExt {
+    My402List *list;
+    struct tagMy402ListExt *next;
+
+    /* optional node pool, enabled by My402ListInitPool() */
+    int pool_chunk_size;
+    My402ListChunk *pool_chunks;
+    My402ListElem *pool_free;
+
+    /* optional block allocator, enabled by My402ListInitBlocks() */
+    int blocks;
+
+    /* optional obj -> elem index for Find, enabled by My402ListEnableIndex() */
+    int index_capacity;
+    int index_used;
+    My402ListElem **index_slots;
+} My402ListExt;
+
+static My402ListExt plainExt;
+
+/*
+ * The table is chained and guarded by a spin lock, which is only taken
+ * when it changes or on a lookup miss: each thread remembers its last
+ * lookup until extGeneration moves. A list's entry is only added or
+ * dropped by whoever owns the list, so a remembered entry stays valid.
+ */
+static My402ListExt **extBuckets;
+static int extNumBuckets;
+static int extCount;
+static char extLock;
+static unsigned int extGeneration;
+static __thread My402List *extCachedList;
+static __thread My402ListExt *extCachedExt;
+static __thread unsigned int extCachedGeneration;
+
+static void extLockTable(){
+    while(__atomic_test_and_set(&extLock, __ATOMIC_ACQUIRE)){
+    }
+}
+
+static void extUnlockTable(){
+    __atomic_clear(&extLock, __ATOMIC_RELEASE);
+}
+
+static unsigned int extHash(My402List* my402List, int numBuckets){
+    unsigned long long key = (unsigned long long)my402List;
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (unsigned int)(key >> 32) & (numBuckets - 1);
+}
+
+/* the entry of my402List, or NULL; the table lock must be held */
+static My402ListExt* extFind(My402List* my402List){
+    if(extNumBuckets == 0){
+        return NULL;
+    }
+    My402ListExt* ext = extBuckets[extHash(my402List, extNumBuckets)];
+    while(ext != NULL && ext->list != my402List){
+        ext = ext->next;
+    }
+    return ext;
+}
+
+/* the options of my402List, &plainExt if it has none */
+static My402ListExt* extOf(My402List* my402List){
+    unsigned int generation = __atomic_load_n(&extGeneration, __ATOMIC_ACQUIRE);
+    if(extCachedList == my402List && extCachedGeneration == generation){
+        return extCachedExt;
+    }
+    My402ListExt* ext = NULL;
+    if(__atomic_load_n(&extCount, __ATOMIC_ACQUIRE) > 0){
+        extLockTable();
+        generation = extGeneration;
+        ext = extFind(my402List);
+        extUnlockTable();
+    }
+    extCachedList = my402List;
+    extCachedExt = ext != NULL ? ext : &plainExt;
+    extCachedGeneration = generation;
+    return extCachedExt;
+}
+
+static int extGrow(){
+    int numBuckets = extNumBuckets > 0 ? extNumBuckets * 2 : DEFAULT_EXT_BUCKETS;
+    My402ListExt** buckets = (My402ListExt**)calloc(numBuckets, sizeof(My402ListExt*));
+    if(buckets == NULL){
+        return FALSE;
+    }
+    for(int a = 0; a < extNumBuckets; a++){
+        My402ListExt* ext = extBuckets[a];
+        while(ext != NULL){
+            My402ListExt* extNext = ext->next;
+            unsigned int bucket = extHash(ext->list, numBuckets);
+            ext->next = buckets[bucket];
+            buckets[bucket] = ext;
+            ext = extNext;
+        }
+    }
+    free(extBuckets);
+    extBuckets = buckets;
+    extNumBuckets = numBuckets;
+    return TRUE;
+}
+
+/* the entry of my402List, added if it has none yet; NULL if out of memory */
+static My402ListExt* extAdd(My402List* my402List){
+    extLockTable();
+    My402ListExt* ext = extFind(my402List);
+    if(ext == NULL && (extCount < extNumBuckets * 2 || extGrow())){
+        ext = (My402ListExt*)calloc(1, sizeof(My402ListExt));
+        if(ext != NULL){
+            unsigned int bucket = extHash(my402List, extNumBuckets);
+            ext->list = my402List;
+            ext->next = extBuckets[bucket];
+            extBuckets[bucket] = ext;
+            __atomic_store_n(&extCount, extCount + 1, __ATOMIC_RELEASE);
+            __atomic_store_n(&extGeneration, extGeneration + 1, __ATOMIC_RELEASE);
+        }
+    }
+    extUnlockTable();
+    return ext;
+}
+
+/* forgets the options of my402List and frees its index; pool chunks still in use are not freed */
+static void extDrop(My402List* my402List){
+    if(__atomic_load_n(&extCount, __ATOMIC_ACQUIRE) == 0){
+        return;
+    }
+    extLockTable();
+    if(extNumBuckets > 0){
+        My402ListExt** link = &extBuckets[extHash(my402List, extNumBuckets)];
+        while(*link != NULL && (*link)->list != my402List){
+            link = &(*link)->next;
+        }
+        if(*link != NULL){
+            My402ListExt* ext = *link;
+            *link = ext->next;
+            free(ext->index_slots);
+            free(ext);
+            __atomic_store_n(&extCount, extCount - 1, __ATOMIC_RELEASE);
+            __atomic_store_n(&extGeneration, extGeneration + 1, __ATOMIC_RELEASE);
+        }
+    }
+    extUnlockTable();
+}
+
+/* blocks are aligned to their size rounded up to a power of 2, so an elem finds its block by masking */
+#define BLOCK_BYTES 512
+
+_Static_assert(sizeof(My402ListBlock) <= BLOCK_BYTES, "My402ListBlock does not fit in BLOCK_BYTES");
+_Static_assert(MY402LIST_BLOCK_ELEMS <= 32, "My402ListBlock.used has 32 bits");
+
+static My402ListBlock* blockOf(My402ListElem* elem){
+    return (My402ListBlock*)((unsigned long long)elem & ~(unsigned long long)(BLOCK_BYTES - 1));
+}
+
+/* a free slot of block, the first one at or after slot from if there is one */
+static My402ListElem* takeBlockSlot(My402ListBlock* block, int from){
+    unsigned int freeSlots = ~block->used & (unsigned int)((1ULL << MY402LIST_BLOCK_ELEMS) - 1);
+    unsigned int after = from < MY402LIST_BLOCK_ELEMS ? freeSlots & (~0U << from) : 0;
+    if(after != 0){
+        freeSlots = after;
+    }
+    if(freeSlots == 0){
+        return NULL;
+    }
+    int slot = __builtin_ctz(freeSlots);
+    block->used |= 1U << slot;
+    return &block->elems[slot];
+}
+
+/* an elem from the block allocator, in prev's or next's block if either has room */
+static My402ListElem* newElemInBlock(My402List* my402List, My402ListElem* prev, My402ListElem* next){
+    My402ListElem* elem = NULL;
+    if(prev != NULL && prev != &my402List->anchor){
+        elem = takeBlockSlot(blockOf(prev), prev - blockOf(prev)->elems + 1);
+    }
+    if(elem == NULL && next != NULL && next != &my402List->anchor){
+        elem = takeBlockSlot(blockOf(next), 0);
+    }
+    if(elem == NULL){
+        My402ListBlock* block = (My402ListBlock*)aligned_alloc(BLOCK_BYTES, BLOCK_BYTES);
+        if(block == NULL){
+            return NULL;
+        }
+        block->used = 0;
+        elem = takeBlockSlot(block, 0);
+    }
+    return elem;
+}
+
+/* prev and next are the elems the new one goes between, which only the block allocator uses */
+static My402ListElem* newElemFromList(My402List* my402List, My402ListExt* ext, My402ListElem* prev, My402ListElem* next){
+    if(ext->blocks){
+        return newElemInBlock(my402List, prev, next);
+    }
+    if(ext->pool_chunk_size <= 0){
+        return (My402ListElem*)malloc(sizeof(My402ListElem));
+    }
+    if(ext->pool_free != NULL){
+        My402ListElem* elem = ext->pool_free;
+        ext->pool_free = elem->next;
+        return elem;
+    }
+    My402ListChunk* chunk = ext->pool_chunks;
+    if(chunk == NULL || chunk->num_used >= chunk->capacity){
+        chunk = (My402ListChunk*)malloc(sizeof(My402ListChunk) + sizeof(My402ListElem) * ext->pool_chunk_size);
+        if(chunk == NULL){
+            return NULL;
+        }
+        chunk->num_used = 0;
+        chunk->capacity = ext->pool_chunk_size;
+        chunk->next = ext->pool_chunks;
+        ext->pool_chunks = chunk;
+    }
+    return &chunk->elems[chunk->num_used++];
+}
+
+static void freeElemToList(My402ListExt* ext, My402ListElem* elem){
+    if(ext->blocks){
+        My402ListBlock* block = blockOf(elem);
+        block->used &= ~(1U << (elem - block->elems));
+        if(block->used == 0){
+            free(block);
+        }
+        return;
+    }
+    if(ext->pool_chunk_size <= 0){
+        free(elem);
+        return;
+    }
+    elem->next = ext->pool_free;
+    ext->pool_free = elem;
+}
+
+/*
+ * The index is a linear-probing table of elems keyed on elem->obj, kept at
+ * most half full. An obj that is in the list more than once has one slot
+ * per elem; Find falls back to the linear scan for those so it still
+ * returns the one closest to First().
+ */
+static unsigned int indexHash(My402ListExt* ext, void* obj){
+    unsigned long long key = (unsigned long long)obj;
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (unsigned int)(key >> 32) & (ext->index_capacity - 1);
+}
+
+static void indexPut(My402ListExt* ext, My402ListElem* elem){
+    unsigned int slot = indexHash(ext, elem->obj);
+    while(ext->index_slots[slot] != NULL){
+        slot = (slot + 1) & (ext->index_capacity - 1);
+    }
+    ext->index_slots[slot] = elem;
+    ext->index_used++;
+}
+
+static int indexResize(My402ListExt* ext, int capacity){
+    My402ListElem** oldSlots = ext->index_slots;
+    int oldCapacity = ext->index_capacity;
+    My402ListElem** newSlots = (My402ListElem**)calloc(capacity, sizeof(My402ListElem*));
+    if(newSlots == NULL){
+        return FALSE;
+    }
+    ext->index_slots = newSlots;
+    ext->index_capacity = capacity;
+    ext->index_used = 0;
+    for(int a = 0; a < oldCapacity; a++){
+        if(oldSlots[a] != NULL){
+            indexPut(ext, oldSlots[a]);
+        }
+    }
+    free(oldSlots);
+    return TRUE;
+}
+
+static int indexInsert(My402ListExt* ext, My402ListElem* elem){
+    if(ext->index_capacity <= 0){
+        return TRUE;
+    }
+    if((ext->index_used + 1) * 2 > ext->index_capacity){
+        if(!indexResize(ext, ext->index_capacity * 2)){
+            return FALSE;
+        }
+    }
+    indexPut(ext, elem);
+    return TRUE;
+}
+
+static void indexRemove(My402ListExt* ext, My402ListElem* elem){
+    if(ext->index_capacity <= 0){
+        return;
+    }
+    unsigned int mask = ext->index_capacity - 1;
+    unsigned int slot = indexHash(ext, elem->obj);
+    while(ext->index_slots[slot] != elem){
+        if(ext->index_slots[slot] == NULL){
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    /* backward-shift the rest of the cluster so no tombstones are needed */
+    unsigned int hole = slot;
+    for(slot = (slot + 1) & mask; ext->index_slots[slot] != NULL; slot = (slot + 1) & mask){
+        unsigned int home = indexHash(ext, ext->index_slots[slot]->obj);
+        if(((slot - home) & mask) >= ((slot - hole) & mask)){
+            ext->index_slots[hole] = ext->index_slots[slot];
+            hole = slot;
+        }
+    }
+    ext->index_slots[hole] = NULL;
+    ext->index_used--;
+}
+
 int My402ListLength(My402List* my402List){
     return my402List->num_members;
 }
@@ -13,12 +360,18 @@ int My402ListEmpty(My402List* my402List){
 }
 
 int My402ListAppend(My402List* my402List, void* obj){
-    My402ListElem* newElem = (My402ListElem*)malloc(sizeof(My402ListElem));
+    My402ListExt* ext = extOf(my402List);
+    My402ListElem* newElem = newElemFromList(my402List, ext, My402ListLast(my402List), NULL);
     if(newElem == NULL){
         fprintf(stderr, "Error malloc in append.\n");
         return FALSE;
     }
     newElem->obj = obj;
+    if(!indexInsert(ext, newElem)){
+        fprintf(stderr, "Error malloc in index.\n");
+        freeElemToList(ext, newElem);
+        return FALSE;
+    }
     if(My402ListEmpty(my402List)){
         my402List->num_members++;
         my402List->anchor.next = newElem;
@@ -37,12 +390,18 @@ int My402ListAppend(My402List* my402List, void* obj){
 }
 
 int My402ListPrepend(My402List* my402List, void* obj){
-    My402ListElem* newElem = (My402ListElem*)malloc(sizeof(My402ListElem));
+    My402ListExt* ext = extOf(my402List);
+    My402ListElem* newElem = newElemFromList(my402List, ext, NULL, My402ListFirst(my402List));
     if(newElem == NULL){
         fprintf(stderr, "Error malloc in prepend.\n");
         return FALSE;
     }
     newElem->obj = obj;
+    if(!indexInsert(ext, newElem)){
+        fprintf(stderr, "Error malloc in index.\n");
+        freeElemToList(ext, newElem);
+        return FALSE;
+    }
     if(My402ListEmpty(my402List)){
         my402List->num_members++;
         my402List->anchor.next = newElem;
@@ -61,34 +420,64 @@ int My402ListPrepend(My402List* my402List, void* obj){
 }
 
 void My402ListUnlink(My402List* my402List, My402ListElem* elem){
+    My402ListExt* ext = extOf(my402List);
+    indexRemove(ext, elem);
     My402ListElem* prev = elem->prev;
     My402ListElem* next = elem->next;
     prev->next = next;
     next->prev = prev;
     elem->prev = NULL;
     elem->next = NULL;
-    free(elem);
+    freeElemToList(ext, elem);
     my402List->num_members--;
 }
 
 void My402ListUnlinkAll(My402List* my402List){
-    My402ListElem* cur = My402ListFirst(my402List);
-    My402ListElem* curNext = My402ListNext(my402List, cur);
-    while(cur != NULL){
-        My402ListUnlink(my402List, cur);
-        cur = curNext;
-        curNext = My402ListNext(my402List, curNext);
+    My402ListExt* ext = extOf(my402List);
+    if(ext->pool_chunk_size > 0){
+        My402ListChunk* chunk = ext->pool_chunks;
+        while(chunk != NULL){
+            My402ListChunk* chunkNext = chunk->next;
+            free(chunk);
+            chunk = chunkNext;
+        }
+        ext->pool_chunks = NULL;
+        ext->pool_free = NULL;
     }
-    My402ListInit(my402List);
+    else{
+        My402ListElem* cur = My402ListFirst(my402List);
+        while(cur != NULL){
+            My402ListElem* curNext = My402ListNext(my402List, cur);
+            freeElemToList(ext, cur);
+            cur = curNext;
+        }
+    }
+    if(ext->index_capacity > 0){
+        memset(ext->index_slots, 0, sizeof(My402ListElem*) * ext->index_capacity);
+        ext->index_used = 0;
+    }
+    my402List->num_members = 0;
+    my402List->anchor.prev = NULL;
+    my402List->anchor.next = NULL;
 }
 
 int My402ListInsertAfter(My402List* my402List, void* obj, My402ListElem* elem){
     if(elem == NULL){
         return My402ListAppend(my402List, obj);
     }
-    my402List->num_members++;
-    My402ListElem* newElem = (My402ListElem*)malloc(sizeof(My402ListElem));
+    My402ListExt* ext = extOf(my402List);
+    My402ListElem* newElem = newElemFromList(my402List, ext, elem, elem->next);
+    if(newElem == NULL){
+        fprintf(stderr, "Error malloc in insert.\n");
+        return FALSE;
+    }
     newElem->obj = obj;
+    if(!indexInsert(ext, newElem)){
+        fprintf(stderr, "Error malloc in index.\n");
+        freeElemToList(ext, newElem);
+        return FALSE;
+    }
+    my402List->num_members++;
     My402ListElem* next = elem->next;
     newElem->prev = elem;
     newElem->next = next;
@@ -101,9 +490,19 @@ int My402ListInsertBefore(My402List* my402List, void* obj, My402ListElem* elem){
     if(elem == NULL){
         return My402ListPrepend(my402List, obj);
     }
-    my402List->num_members++;
-    My402ListElem* newElem = (My402ListElem*)malloc(sizeof(My402ListElem));
+    My402ListExt* ext = extOf(my402List);
+    My402ListElem* newElem = newElemFromList(my402List, ext, elem->prev, elem);
+    if(newElem == NULL){
+        fprintf(stderr, "Error malloc in insert.\n");
+        return FALSE;
+    }
     newElem->obj = obj;
+    if(!indexInsert(ext, newElem)){
+        fprintf(stderr, "Error malloc in index.\n");
+        freeElemToList(ext, newElem);
+        return FALSE;
+    }
+    my402List->num_members++;
     My402ListElem* prev = elem->prev;
     newElem->prev = prev;
     newElem->next = elem;
@@ -141,6 +540,21 @@ My402ListElem* My402ListPrev(My402List* my402List, My402ListElem* cur){
 }
 
 My402ListElem* My402ListFind(My402List* my402List, void* obj){
+    My402ListExt* ext = extOf(my402List);
+    if(ext->index_capacity > 0){
+        unsigned int mask = ext->index_capacity - 1;
+        My402ListElem* found = NULL;
+        int foundCount = 0;
+        for(unsigned int slot = indexHash(ext, obj); ext->index_slots[slot] != NULL; slot = (slot + 1) & mask){
+            if(ext->index_slots[slot]->obj == obj){
+                found = ext->index_slots[slot];
+                foundCount++;
+            }
+        }
+        if(foundCount <= 1){
+            return found;
+        }
+    }
     for(My402ListElem* cur = My402ListFirst(my402List); cur != NULL; cur = My402ListNext(my402List, cur)){
         if(cur->obj == obj){
             return cur;
@@ -149,10 +563,301 @@ My402ListElem* My402ListFind(My402List* my402List, void* obj){
     return NULL;
 }
 
+/* also turns off any pool, index or block allocator the list had */
 int My402ListInit(My402List* my402List){
     memset(my402List, 0, sizeof(My402List));
     my402List->num_members = 0;
     my402List->anchor.prev = NULL;
     my402List->anchor.next = NULL;
+    extDrop(my402List);
+    return TRUE;
+}
+
+int My402ListInitPool(My402List* my402List, int chunkSize){
+    My402ListInit(my402List);
+    My402ListExt* ext = extAdd(my402List);
+    if(ext == NULL){
+        fprintf(stderr, "Error malloc in pool.\n");
+        return FALSE;
+    }
+    ext->pool_chunk_size = chunkSize > 0 ? chunkSize : DEFAULT_POOL_CHUNK_SIZE;
     return TRUE;
-}
\ No newline at end of file
+}
+
+int My402ListInitBlocks(My402List* my402List){
+    My402ListInit(my402List);
+    My402ListExt* ext = extAdd(my402List);
+    if(ext == NULL){
+        fprintf(stderr, "Error malloc in block list.\n");
+        return FALSE;
+    }
+    ext->blocks = TRUE;
+    return TRUE;
+}
+
+int My402ListEnableIndex(My402List* my402List){
+    if(extOf(my402List)->index_capacity > 0){
+        return TRUE;
+    }
+    My402ListExt* ext = extAdd(my402List);
+    if(ext == NULL){
+        fprintf(stderr, "Error malloc in index.\n");
+        return FALSE;
+    }
+    int capacity = DEFAULT_INDEX_CAPACITY;
+    while(capacity < my402List->num_members * 2 + 2){
+        capacity *= 2;
+    }
+    ext->index_slots = (My402ListElem**)calloc(capacity, sizeof(My402ListElem*));
+    if(ext->index_slots == NULL){
+        fprintf(stderr, "Error malloc in index.\n");
+        return FALSE;
+    }
+    ext->index_capacity = capacity;
+    ext->index_used = 0;
+    for(My402ListElem* cur = My402ListFirst(my402List); cur != NULL; cur = My402ListNext(my402List, cur)){
+        indexPut(ext, cur);
+    }
+    return TRUE;
+}
+
+void My402ListDisableIndex(My402List* my402List){
+    My402ListExt* ext = extOf(my402List);
+    if(ext->index_capacity <= 0){
+        return;
+    }
+    free(ext->index_slots);
+    ext->index_slots = NULL;
+    ext->index_capacity = 0;
+    ext->index_used = 0;
+    if(ext->pool_chunk_size <= 0 && !ext->blocks){
+        extDrop(my402List);
+    }
+}
+
+/*
+ * Hands src's pool chunks to dst, for when src's elems have been relinked
+ * into dst (e.g. by a merge), and leaves src empty. If src has a pool, dst
+ * must have one too; a plain src is only emptied. Relinked elems are not
+ * added to dst's index.
+ */
+void My402ListAdoptPool(My402List* dst, My402List* src){
+    My402ListExt* srcExt = extOf(src);
+    if(srcExt->pool_chunks != NULL){
+        My402ListExt* dstExt = extOf(dst);
+        My402ListChunk* last = srcExt->pool_chunks;
+        while(last->next != NULL){
+            last = last->next;
+        }
+        if(dstExt->pool_chunks == NULL){
+            dstExt->pool_chunks = srcExt->pool_chunks;
+        }
+        else{
+            last->next = dstExt->pool_chunks->next;
+            dstExt->pool_chunks->next = srcExt->pool_chunks;
+        }
+    }
+    src->num_members = 0;
+    src->anchor.prev = NULL;
+    src->anchor.next = NULL;
+    if(srcExt->pool_chunk_size > 0){
+        srcExt->pool_chunks = NULL;
+        srcExt->pool_free = NULL;
+    }
+    if(srcExt->index_capacity > 0){
+        memset(srcExt->index_slots, 0, sizeof(My402ListElem*) * srcExt->index_capacity);
+        srcExt->index_used = 0;
+    }
+}
+
+/* grows the index, if there is one, so count more elems fit without a resize */
+static int indexReserve(My402ListExt* ext, int count){
+    if(ext->index_capacity <= 0){
+        return TRUE;
+    }
+    int capacity = ext->index_capacity;
+    while((ext->index_used + count) * 2 > capacity){
+        capacity *= 2;
+    }
+    return capacity == ext->index_capacity || indexResize(ext, capacity);
+}
+
+/* unhooks first..last from my402List; the run keeps its inner links */
+static void detachRun(My402List* my402List, My402ListElem* first, My402ListElem* last, int count){
+    if(count >= my402List->num_members){
+        my402List->anchor.next = NULL;
+        my402List->anchor.prev = NULL;
+    }
+    else{
+        first->prev->next = last->next;
+        last->next->prev = first->prev;
+    }
+    my402List->num_members -= count;
+}
+
+/* hooks first..last in after elem, or at the end if elem is NULL */
+static void attachRun(My402List* my402List, My402ListElem* elem, My402ListElem* first, My402ListElem* last, int count){
+    if(My402ListEmpty(my402List)){
+        my402List->anchor.next = first;
+        my402List->anchor.prev = last;
+        first->prev = &my402List->anchor;
+        last->next = &my402List->anchor;
+    }
+    else{
+        if(elem == NULL){
+            elem = my402List->anchor.prev;
+        }
+        My402ListElem* next = elem->next;
+        elem->next = first;
+        first->prev = elem;
+        last->next = next;
+        next->prev = last;
+    }
+    my402List->num_members += count;
+}
+
+/*
+ * Moves the run first..last of src, count elems long, into dst right after
+ * elem, or to the end of dst if elem is NULL. The elems are relinked, not
+ * copied, so it is O(1) unless src or dst has an index, which is updated
+ * one elem at a time. dst may be src, if elem is not in the run. Elems of a
+ * pooled list live in its chunks, so they can only move within it; use
+ * My402ListConcat() to move all of them.
+ */
+int My402ListSplice(My402List* dst, My402ListElem* elem, My402List* src, My402ListElem* first, My402ListElem* last, int count){
+    if(count <= 0){
+        return TRUE;
+    }
+    if(dst != src){
+        My402ListExt* srcExt = extOf(src);
+        My402ListExt* dstExt = extOf(dst);
+        if(srcExt->pool_chunk_size > 0 || dstExt->pool_chunk_size > 0){
+            fprintf(stderr, "Cannot splice elems between pooled lists.\n");
+            return FALSE;
+        }
+        if(srcExt->blocks != dstExt->blocks){
+            fprintf(stderr, "Cannot splice elems between block and plain lists.\n");
+            return FALSE;
+        }
+        if(!indexReserve(dstExt, count)){
+            fprintf(stderr, "Error malloc in index.\n");
+            return FALSE;
+        }
+        if(srcExt->index_capacity > 0 || dstExt->index_capacity > 0){
+            My402ListElem* cur = first;
+            for(int a = 0; a < count; a++){
+                indexRemove(srcExt, cur);
+                if(dstExt->index_capacity > 0){
+                    indexPut(dstExt, cur);
+                }
+                cur = cur->next;
+            }
+        }
+    }
+    detachRun(src, first, last, count);
+    attachRun(dst, elem, first, last, count);
+    return TRUE;
+}
+
+/* moves every elem of src to the end of dst; both lists must have the same backend */
+int My402ListConcat(My402List* dst, My402List* src){
+    My402ListExt* srcExt = extOf(src);
+    My402ListExt* dstExt = extOf(dst);
+    if((srcExt->pool_chunk_size > 0) != (dstExt->pool_chunk_size > 0) || srcExt->blocks != dstExt->blocks){
+        fprintf(stderr, "Cannot concat lists with different backends.\n");
+        return FALSE;
+    }
+    if(srcExt->pool_chunk_size <= 0){
+        return My402ListSplice(dst, NULL, src, My402ListFirst(src), My402ListLast(src), My402ListLength(src));
+    }
+    if(!indexReserve(dstExt, My402ListLength(src))){
+        fprintf(stderr, "Error malloc in index.\n");
+        return FALSE;
+    }
+    if(!My402ListEmpty(src)){
+        My402ListElem* first = My402ListFirst(src);
+        My402ListElem* last = My402ListLast(src);
+        int count = My402ListLength(src);
+        if(dstExt->index_capacity > 0){
+            for(My402ListElem* cur = first; cur != &src->anchor; cur = cur->next){
+                indexPut(dstExt, cur);
+            }
+        }
+        detachRun(src, first, last, count);
+        attachRun(dst, NULL, first, last, count);
+    }
+    My402ListAdoptPool(dst, src);
+    return TRUE;
+}
+
+/*
+ * Moves elem and everything after it to the end of rest. count is the
+ * number of elems moved, or -1 to have them counted, which is O(n).
+ */
+int My402ListSplitAt(My402List* my402List, My402ListElem* elem, My402List* rest, int count){
+    if(count < 0){
+        count = 0;
+        for(My402ListElem* cur = elem; cur != NULL; cur = My402ListNext(my402List, cur)){
+            count++;
+        }
+    }
+    return My402ListSplice(rest, NULL, my402List, elem, My402ListLast(my402List), count);
+}
+
+/*
+ * Appends num objs in order. For a pooled list the elems come out of one
+ * chunk, which takes a single malloc when the current chunk is too full;
+ * an unpooled list still mallocs each elem, since Unlink frees them one
+ * by one.
+ */
+int My402ListAppendArray(My402List* my402List, void* objs[], int num){
+    My402ListExt* ext = extOf(my402List);
+    if(num <= 0){
+        return TRUE;
+    }
+    if(ext->pool_chunk_size <= 0){
+        /* the block allocator already mallocs once per block */
+        for(int a = 0; a < num; a++){
+            if(!My402ListAppend(my402List, objs[a])){
+                return FALSE;
+            }
+        }
+        return TRUE;
+    }
+    if(!indexReserve(ext, num)){
+        fprintf(stderr, "Error malloc in index.\n");
+        return FALSE;
+    }
+    My402ListChunk* chunk = ext->pool_chunks;
+    if(chunk == NULL || chunk->capacity - chunk->num_used < num){
+        int capacity = max(num, ext->pool_chunk_size);
+        chunk = (My402ListChunk*)malloc(sizeof(My402ListChunk) + sizeof(My402ListElem) * capacity);
+        if(chunk == NULL){
+            fprintf(stderr, "Error malloc in append.\n");
+            return FALSE;
+        }
+        chunk->num_used = 0;
+        chunk->capacity = capacity;
+        if(ext->pool_chunks != NULL && capacity == num){
+            /* a chunk used up right away goes behind the current one, which still has room */
+            chunk->next = ext->pool_chunks->next;
+            ext->pool_chunks->next = chunk;
+        }
+        else{
+            chunk->next = ext->pool_chunks;
+            ext->pool_chunks = chunk;
+        }
+    }
+    My402ListElem* elems = &chunk->elems[chunk->num_used];
+    chunk->num_used += num;
+    for(int a = 0; a < num; a++){
+        elems[a].obj = objs[a];
+        elems[a].prev = a > 0 ? &elems[a - 1] : NULL;
+        elems[a].next = a + 1 < num ? &elems[a + 1] : NULL;
+        if(ext->index_capacity > 0){
+            indexPut(ext, &elems[a]);
+        }
+    }
+    attachRun(my402List, NULL, &elems[0], &elems[num - 1], num);
+    return TRUE;
+}
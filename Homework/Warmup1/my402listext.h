@@ -0,0 +1,25 @@
+#ifndef _MY402LISTEXT_H_
+#define _MY402LISTEXT_H_
+
+#include "my402list.h"
+
+/*
+ * Options and bulk moves on top of the stock My402List. my402list.h is
+ * the stock header, so nothing here adds fields to My402List: the state
+ * of a list's options lives in a side table inside my402list.c, and a list
+ * that uses none of them costs nothing extra.
+ */
+
+/* node pool, index and block allocator; My402ListInit() turns them all off */
+extern int My402ListInitPool(My402List*, int);
+extern int My402ListInitBlocks(My402List*);
+extern int My402ListEnableIndex(My402List*);
+extern void My402ListDisableIndex(My402List*);
+extern void My402ListAdoptPool(My402List*, My402List*);
+
+extern int My402ListSplice(My402List*, My402ListElem*, My402List*, My402ListElem*, My402ListElem*, int);
+extern int My402ListConcat(My402List*, My402List*);
+extern int My402ListSplitAt(My402List*, My402ListElem*, My402List*, int);
+extern int My402ListAppendArray(My402List*, void**, int);
+
+#endif /*_MY402LISTEXT_H_*/
@@ -6,7 +6,6 @@ typedef struct tagMy402ListElemObj{
     char time[16];
     char amount[16];
     char desc[25];
-    char timeStr[16];
     long timestamp;
     long long amountNum;
     int lineNum;
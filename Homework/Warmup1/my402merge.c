@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "my402merge.h"
+#include "my402sort.h"
+
+int My402MergeInit(My402Merge* merge, int numSources){
+    memset(merge, 0, sizeof(My402Merge));
+    merge->sources = (void**)calloc(numSources, sizeof(void*));
+    merge->next = (My402RecordNextFunc*)calloc(numSources, sizeof(My402RecordNextFunc));
+    merge->heads = (My402Record*)calloc(numSources, sizeof(My402Record));
+    merge->heap = (int*)calloc(numSources, sizeof(int));
+    if(merge->sources == NULL || merge->next == NULL || merge->heads == NULL || merge->heap == NULL){
+        My402MergeFree(merge);
+        return FALSE;
+    }
+    merge->num_sources = numSources;
+    return TRUE;
+}
+
+void My402MergeSetSource(My402Merge* merge, int index, void* source, My402RecordNextFunc next){
+    merge->sources[index] = source;
+    merge->next[index] = next;
+}
+
+static int compareHeads(My402Merge* merge, int source1, int source2){
+    unsigned int time1 = merge->heads[source1].timestamp;
+    unsigned int time2 = merge->heads[source2].timestamp;
+    if(time1 != time2){
+        return time1 < time2 ? -1 : 1;
+    }
+    return source1 - source2;
+}
+
+static void siftDown(My402Merge* merge, int index){
+    int* heap = merge->heap;
+    while(TRUE){
+        int smallest = index;
+        int left = index * 2 + 1;
+        int right = left + 1;
+        if(left < merge->heap_size && (My402SortComparisons++, compareHeads(merge, heap[left], heap[smallest]) < 0)){
+            smallest = left;
+        }
+        if(right < merge->heap_size && (My402SortComparisons++, compareHeads(merge, heap[right], heap[smallest]) < 0)){
+            smallest = right;
+        }
+        if(smallest == index){
+            return;
+        }
+        int temp = heap[index];
+        heap[index] = heap[smallest];
+        heap[smallest] = temp;
+        index = smallest;
+    }
+}
+
+/* reads the first record of every source; call after all sources are set */
+void My402MergeStart(My402Merge* merge){
+    merge->heap_size = 0;
+    for(int a = 0; a < merge->num_sources; a++){
+        if(merge->next[a](merge->sources[a], &merge->heads[a])){
+            merge->heap[merge->heap_size++] = a;
+        }
+    }
+    for(int a = merge->heap_size / 2 - 1; a >= 0; a--){
+        siftDown(merge, a);
+    }
+}
+
+/* copies the smallest head to record and its source index to *source */
+int My402MergeNext(My402Merge* merge, My402Record* record, int* source){
+    if(merge->heap_size == 0){
+        return FALSE;
+    }
+    int top = merge->heap[0];
+    *record = merge->heads[top];
+    My402SortSwaps++;
+    if(source != NULL){
+        *source = top;
+    }
+    if(!merge->next[top](merge->sources[top], &merge->heads[top])){
+        merge->heap[0] = merge->heap[--merge->heap_size];
+    }
+    siftDown(merge, 0);
+    return TRUE;
+}
+
+void My402MergeFree(My402Merge* merge){
+    free(merge->sources);
+    free(merge->next);
+    free(merge->heads);
+    free(merge->heap);
+    memset(merge, 0, sizeof(My402Merge));
+}
+
+/* an already unlinked temp file in $TMPDIR, or /tmp */
+static FILE* openTempFile(){
+    const char* dir = getenv("TMPDIR");
+    if(dir == NULL || *dir == '\0'){
+        dir = "/tmp";
+    }
+    char path[MAXPATHLENGTH];
+    if(snprintf(path, sizeof(path), "%s/warmup1-run-XXXXXX", dir) >= (int)sizeof(path)){
+        return NULL;
+    }
+    int fd = mkstemp(path);
+    if(fd < 0){
+        return NULL;
+    }
+    unlink(path);
+    FILE* file = fdopen(fd, "w+");
+    if(file == NULL){
+        close(fd);
+    }
+    return file;
+}
+
+static void spillRecord(FILE* file, unsigned int timestamp, int amount, int lineNum, const char* desc){
+    unsigned char descLen = (unsigned char)strlen(desc);
+    unsigned int header[3];
+    header[0] = timestamp;
+    header[1] = (unsigned int)amount;
+    header[2] = (unsigned int)lineNum;
+    if(fwrite(header, sizeof(header), 1, file) != 1 || fwrite(&descLen, 1, 1, file) != 1 || fwrite(desc, 1, descLen, file) != descLen){
+        fprintf(stderr, "Error writing a sorted run.\n");
+        exit(1);
+    }
+}
+
+static FILE* openRun(){
+    FILE* file = openTempFile();
+    if(file == NULL){
+        fprintf(stderr, "Error creating a temp file for a sorted run.\n");
+        exit(1);
+    }
+    return file;
+}
+
+static void finishRun(FILE* file){
+    if(fflush(file) != 0){
+        fprintf(stderr, "Error writing a sorted run.\n");
+        exit(1);
+    }
+    rewind(file);
+}
+
+/*
+ * Writes the rows of a sorted ledger to a temp file and rewinds it. Each
+ * record is timestamp, amount and lineNum as 4-byte ints in host order,
+ * one byte of description length and then the description.
+ */
+FILE* My402SpillLedger(My402Ledger* ledger){
+    FILE* file = openRun();
+    for(int a = 0; a < ledger->num_rows; a++){
+        spillRecord(file, ledger->timestamp[a], ledger->amount[a], ledger->lineNum[a], My402LedgerDesc(ledger, a));
+    }
+    finishRun(file);
+    return file;
+}
+
+/*
+ * Drains a started merge into a new run in the same format, written
+ * through a buffer of bufferSize bytes, and rewinds it.
+ */
+FILE* My402SpillMerge(My402Merge* merge, size_t bufferSize){
+    FILE* file = openRun();
+    setvbuf(file, NULL, _IOFBF, bufferSize);
+    My402Record record;
+    while(My402MergeNext(merge, &record, NULL)){
+        spillRecord(file, record.timestamp, record.amount, record.lineNum, record.desc);
+    }
+    finishRun(file);
+    return file;
+}
+
+int My402SpillNext(void* source, My402Record* record){
+    FILE* file = (FILE*)source;
+    unsigned int header[3];
+    unsigned char descLen = 0;
+    if(fread(header, sizeof(header), 1, file) != 1){
+        return FALSE;
+    }
+    if(fread(&descLen, 1, 1, file) != 1 || descLen >= sizeof(record->desc) || fread(record->desc, 1, descLen, file) != descLen){
+        fprintf(stderr, "Error reading a sorted run.\n");
+        exit(1);
+    }
+    record->timestamp = header[0];
+    record->amount = (int)header[1];
+    record->lineNum = (int)header[2];
+    record->desc[descLen] = '\0';
+    return TRUE;
+}
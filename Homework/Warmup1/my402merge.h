@@ -0,0 +1,45 @@
+#ifndef _MY402MERGE_H_
+#define _MY402MERGE_H_
+
+#include <stdio.h>
+
+#include "cs402.h"
+#include "my402ledger.h"
+
+/* one transaction on its way through a k-way merge */
+typedef struct tagMy402Record {
+    unsigned int timestamp;
+    int amount;
+    int lineNum;
+    char desc[25];
+} My402Record;
+
+/* fills in the next record of a sorted source, returns FALSE at its end */
+typedef int (*My402RecordNextFunc)(void*, My402Record*);
+
+/*
+ * Streaming k-way merge of sorted record sources with a binary heap of
+ * their heads. Ties go to the lower-numbered source, so if the sources
+ * are consecutive pieces of one input the merge is stable.
+ */
+typedef struct tagMy402Merge {
+    int num_sources;
+    void **sources;
+    My402RecordNextFunc *next;
+    My402Record *heads;
+    int *heap;
+    int heap_size;
+} My402Merge;
+
+extern int  My402MergeInit(My402Merge*, int);
+extern void My402MergeSetSource(My402Merge*, int, void*, My402RecordNextFunc);
+extern void My402MergeStart(My402Merge*);
+extern int  My402MergeNext(My402Merge*, My402Record*, int*);
+extern void My402MergeFree(My402Merge*);
+
+/* sorted runs spilled to unlinked temp files */
+extern FILE *My402SpillLedger(My402Ledger*);
+extern FILE *My402SpillMerge(My402Merge*, size_t);
+extern int  My402SpillNext(void*, My402Record*);
+
+#endif /*_MY402MERGE_H_*/
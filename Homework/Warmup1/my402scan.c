@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+#include "my402scan.h"
+
+void (*My402ScanLine)(const char*, int, My402LineScan*) = My402ScanLineScalar;
+
+static void clearScan(int len, My402LineScan* scan){
+    int words = (len + 63) / 64;
+    scan->len = len;
+    scan->tabCount = 0;
+    memset(scan->space, 0, sizeof(unsigned long long) * words);
+    memset(scan->nonDigit, 0, sizeof(unsigned long long) * words);
+    memset(scan->dot, 0, sizeof(unsigned long long) * words);
+}
+
+void My402ScanLineScalar(const char* line, int len, My402LineScan* scan){
+    clearScan(len, scan);
+    for(int a = 0; a < len; a++){
+        unsigned char c = (unsigned char)line[a];
+        unsigned long long bit = 1ULL << (a & 63);
+        if(c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t'){
+            scan->space[a >> 6] |= bit;
+        }
+        if(c == '\t'){
+            scan->tabCount++;
+        }
+        if((unsigned char)(c - '0') > 9){
+            scan->nonDigit[a >> 6] |= bit;
+        }
+        if(c == '.'){
+            scan->dot[a >> 6] |= bit;
+        }
+    }
+}
+
+#ifdef HAVE_X86_SIMD
+
+/*
+ * Both vector versions classify a whole block with byte compares and
+ * movemask. Unsigned range checks use min_epu8(x, hi) == x. The short tail
+ * is copied into a zeroed block so nothing past the line is ever read.
+ */
+static void scanBlockSSE2(const char* block, int offset, int validBytes, My402LineScan* scan){
+    __m128i v = _mm_loadu_si128((const __m128i*)block);
+    __m128i fromTab = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    __m128i isCtrlSpace = _mm_cmpeq_epi8(_mm_min_epu8(fromTab, _mm_set1_epi8('\r' - '\t')), fromTab);
+    __m128i isSpace = _mm_or_si128(isCtrlSpace, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    __m128i fromZero = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(fromZero, _mm_set1_epi8(9)), fromZero);
+
+    unsigned long long valid = validBytes >= 16 ? 0xffffULL : (1ULL << validBytes) - 1;
+    unsigned long long space = (unsigned long long)_mm_movemask_epi8(isSpace) & valid;
+    unsigned long long nonDigit = (unsigned long long)(~_mm_movemask_epi8(isDigit)) & valid;
+    unsigned long long dot = (unsigned long long)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.'))) & valid;
+    unsigned long long tab = (unsigned long long)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))) & valid;
+
+    scan->space[offset >> 6] |= space << (offset & 63);
+    scan->nonDigit[offset >> 6] |= nonDigit << (offset & 63);
+    scan->dot[offset >> 6] |= dot << (offset & 63);
+    scan->tabCount += __builtin_popcountll(tab);
+}
+
+void My402ScanLineSSE2(const char* line, int len, My402LineScan* scan){
+    clearScan(len, scan);
+    int a = 0;
+    for(; a + 16 <= len; a += 16){
+        scanBlockSSE2(line + a, a, 16, scan);
+    }
+    if(a < len){
+        char tail[16];
+        memset(tail, 0, sizeof(tail));
+        memcpy(tail, line + a, len - a);
+        scanBlockSSE2(tail, a, len - a, scan);
+    }
+}
+
+__attribute__((target("avx2")))
+static void scanBlockAVX2(const char* block, int offset, int validBytes, My402LineScan* scan){
+    __m256i v = _mm256_loadu_si256((const __m256i*)block);
+    __m256i fromTab = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    __m256i isCtrlSpace = _mm256_cmpeq_epi8(_mm256_min_epu8(fromTab, _mm256_set1_epi8('\r' - '\t')), fromTab);
+    __m256i isSpace = _mm256_or_si256(isCtrlSpace, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+    __m256i fromZero = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+    __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(fromZero, _mm256_set1_epi8(9)), fromZero);
+
+    unsigned long long valid = validBytes >= 32 ? 0xffffffffULL : (1ULL << validBytes) - 1;
+    unsigned long long space = (unsigned int)_mm256_movemask_epi8(isSpace) & valid;
+    unsigned long long nonDigit = (unsigned int)(~_mm256_movemask_epi8(isDigit)) & valid;
+    unsigned long long dot = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))) & valid;
+    unsigned long long tab = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))) & valid;
+
+    scan->space[offset >> 6] |= space << (offset & 63);
+    scan->nonDigit[offset >> 6] |= nonDigit << (offset & 63);
+    scan->dot[offset >> 6] |= dot << (offset & 63);
+    scan->tabCount += __builtin_popcountll(tab);
+}
+
+__attribute__((target("avx2")))
+void My402ScanLineAVX2(const char* line, int len, My402LineScan* scan){
+    clearScan(len, scan);
+    int a = 0;
+    for(; a + 32 <= len; a += 32){
+        scanBlockAVX2(line + a, a, 32, scan);
+    }
+    if(a + 16 <= len){
+        scanBlockSSE2(line + a, a, 16, scan);
+        a += 16;
+    }
+    if(a < len){
+        char tail[16];
+        memset(tail, 0, sizeof(tail));
+        memcpy(tail, line + a, len - a);
+        scanBlockSSE2(tail, a, len - a, scan);
+    }
+}
+
+#else /* ~HAVE_X86_SIMD */
+
+void My402ScanLineSSE2(const char* line, int len, My402LineScan* scan){
+    My402ScanLineScalar(line, len, scan);
+}
+
+void My402ScanLineAVX2(const char* line, int len, My402LineScan* scan){
+    My402ScanLineScalar(line, len, scan);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+/*
+ * Picks the scanner: NULL selects the widest one this CPU supports,
+ * otherwise "scalar", "sse2" or "avx2". Returns the name of the scanner
+ * in use, or NULL if the requested one is not available.
+ */
+const char* My402ScanInit(const char* name){
+    int haveSSE2 = FALSE;
+    int haveAVX2 = FALSE;
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    haveSSE2 = __builtin_cpu_supports("sse2");
+    haveAVX2 = __builtin_cpu_supports("avx2");
+#endif
+    if(name == NULL){
+        name = haveAVX2 ? "avx2" : (haveSSE2 ? "sse2" : "scalar");
+    }
+    if(strcmp(name, "avx2") == 0 && haveAVX2){
+        My402ScanLine = My402ScanLineAVX2;
+        return "avx2";
+    }
+    if(strcmp(name, "sse2") == 0 && haveSSE2){
+        My402ScanLine = My402ScanLineSSE2;
+        return "sse2";
+    }
+    if(strcmp(name, "scalar") == 0){
+        My402ScanLine = My402ScanLineScalar;
+        return "scalar";
+    }
+    return NULL;
+}
+
+/* number of set bits in [start, end) */
+int My402ScanCount(const unsigned long long* mask, int start, int end){
+    int count = 0;
+    while(start < end){
+        int bit = start & 63;
+        int take = min(64 - bit, end - start);
+        unsigned long long word = mask[start >> 6] >> bit;
+        if(take < 64){
+            word &= (1ULL << take) - 1;
+        }
+        count += __builtin_popcountll(word);
+        start += take;
+    }
+    return count;
+}
+
+/* index of the first bit in [start, end) equal to want, or end if none */
+int My402ScanNext(const unsigned long long* mask, int start, int end, int want){
+    while(start < end){
+        int bit = start & 63;
+        unsigned long long word = mask[start >> 6];
+        if(!want){
+            word = ~word;
+        }
+        word >>= bit;
+        if(word != 0){
+            int found = start + __builtin_ctzll(word);
+            return found < end ? found : end;
+        }
+        start += 64 - bit;
+    }
+    return end;
+}
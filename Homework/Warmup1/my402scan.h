@@ -0,0 +1,33 @@
+#ifndef _MY402SCAN_H_
+#define _MY402SCAN_H_
+
+#include "cs402.h"
+
+#define MAX_LINE_LEN 1024
+#define SCAN_MASK_WORDS ((MAX_LINE_LEN + 63) / 64)
+
+/*
+ * Per-byte classification of one tfile line, one bit per byte. "space" is
+ * the whitespace set sscanf uses to split %s fields.
+ */
+typedef struct tagMy402LineScan {
+    int len;
+    int tabCount;
+    unsigned long long space[SCAN_MASK_WORDS];
+    unsigned long long nonDigit[SCAN_MASK_WORDS];
+    unsigned long long dot[SCAN_MASK_WORDS];
+} My402LineScan;
+
+/* line must be at most MAX_LINE_LEN bytes */
+extern void (*My402ScanLine)(const char*, int, My402LineScan*);
+
+extern void My402ScanLineScalar(const char*, int, My402LineScan*);
+extern void My402ScanLineSSE2(const char*, int, My402LineScan*);
+extern void My402ScanLineAVX2(const char*, int, My402LineScan*);
+
+extern const char *My402ScanInit(const char*);
+
+extern int My402ScanCount(const unsigned long long*, int, int);
+extern int My402ScanNext(const unsigned long long*, int, int, int);
+
+#endif /*_MY402SCAN_H_*/
@@ -0,0 +1,532 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "my402list.h"
+#include "my402listext.h"
+#include "my402listobj.h"
+#include "my402ledger.h"
+#include "my402sort.h"
+
+long long My402SortComparisons = 0;
+long long My402SortSwaps = 0;
+
+/* sorts on -j threads add their counts once, when they finish */
+static void addSortCounts(long long comparisons, long long swaps){
+    __atomic_fetch_add(&My402SortComparisons, comparisons, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&My402SortSwaps, swaps, __ATOMIC_RELAXED);
+}
+
+void BubbleForward(My402List *pList, My402ListElem **pp_elem1, My402ListElem **pp_elem2)
+    /* (*pp_elem1) must be closer to First() than (*pp_elem2) */
+{
+    My402ListElem* elem1 = (*pp_elem1), *elem2 = (*pp_elem2);
+    void* obj1 = elem1->obj, *obj2 = elem2->obj;
+    My402ListElem* elem1prev = My402ListPrev(pList, elem1);
+/*  My402ListElem *elem1next=My402ListNext(pList, elem1); */
+/*  My402ListElem *elem2prev=My402ListPrev(pList, elem2); */
+    My402ListElem* elem2next = My402ListNext(pList, elem2);
+
+    My402ListUnlink(pList, elem1);
+    My402ListUnlink(pList, elem2);
+    if (elem1prev == NULL) {
+        (void)My402ListPrepend(pList, obj2);
+        *pp_elem1 = My402ListFirst(pList);
+    }
+    else {
+        (void)My402ListInsertAfter(pList, obj2, elem1prev);
+        *pp_elem1 = My402ListNext(pList, elem1prev);
+    }
+    if (elem2next == NULL) {
+        (void)My402ListAppend(pList, obj1);
+        *pp_elem2 = My402ListLast(pList);
+    }
+    else {
+        (void)My402ListInsertBefore(pList, obj1, elem2next);
+        *pp_elem2 = My402ListPrev(pList, elem2next);
+    }
+}
+
+void BubbleSortForwardList(My402List *pList, int num_items){
+    My402ListElem* elem = NULL;
+    int i = 0;
+    long long comparisons = 0, swaps = 0;
+
+    if (My402ListLength(pList) != num_items) {
+        fprintf(stderr, "List length is not %1d in BubbleSortForwardList().\n", num_items);
+        exit(1);
+    }
+    for (i = 0; i < num_items; i++) {
+        int j = 0, something_swapped = FALSE;
+        My402ListElem* next_elem = NULL;
+
+        for (elem = My402ListFirst(pList), j = 0; j < num_items-i - 1; elem = next_elem, j++) {
+            My402ListElemObj* curObj = (My402ListElemObj*)(elem->obj);
+            long long cur_val = curObj->timestamp;
+
+            next_elem = My402ListNext(pList, elem);
+            My402ListElemObj* nextObj = (My402ListElemObj*)(next_elem->obj);
+            long long next_val = nextObj->timestamp;
+
+            if(cur_val == next_val){
+                fprintf(stderr, "line%d and %d, field: time, there are two identical timestamps.\n", curObj->lineNum, nextObj->lineNum);
+                exit(1);
+            }
+
+            comparisons++;
+            if (cur_val > next_val) {
+                BubbleForward(pList, &elem, &next_elem);
+                something_swapped = TRUE;
+                swaps++;
+            }
+        }
+        if(!something_swapped){
+            break;
+        }
+    }
+    addSortCounts(comparisons, swaps);
+}
+
+/*
+ * Stable bottom-up merge sort on timestamp: relinks the existing elems as a
+ * NULL-terminated chain through next, then rebuilds prev and the anchor.
+ * Duplicate timestamps are left for checkDuplicateTime().
+ */
+void MergeSortLinks(My402List* pList){
+    if(My402ListLength(pList) < 2){
+        return;
+    }
+
+    My402ListElem* anchor = &pList->anchor;
+    My402ListElem* head = anchor->next;
+    anchor->prev->next = NULL;
+    long long comparisons = 0, swaps = 0;
+
+    for(int width = 1; ; width *= 2){
+        My402ListElem* left = head;
+        My402ListElem* tail = NULL;
+        int mergeCount = 0;
+        head = NULL;
+
+        while(left != NULL){
+            mergeCount++;
+            My402ListElem* right = left;
+            int leftSize = 0;
+            while(leftSize < width && right != NULL){
+                leftSize++;
+                right = right->next;
+            }
+            int rightSize = width;
+
+            while(leftSize > 0 || (rightSize > 0 && right != NULL)){
+                My402ListElem* elem = NULL;
+                if(leftSize == 0){
+                    elem = right;
+                    right = right->next;
+                    rightSize--;
+                }
+                else if(rightSize == 0 || right == NULL){
+                    elem = left;
+                    left = left->next;
+                    leftSize--;
+                }
+                else if(comparisons++, ((My402ListElemObj*)left->obj)->timestamp <= ((My402ListElemObj*)right->obj)->timestamp){
+                    elem = left;
+                    left = left->next;
+                    leftSize--;
+                }
+                else{
+                    elem = right;
+                    right = right->next;
+                    rightSize--;
+                }
+
+                swaps++;
+                if(tail == NULL){
+                    head = elem;
+                }
+                else{
+                    tail->next = elem;
+                }
+                tail = elem;
+            }
+            left = right;
+        }
+        tail->next = NULL;
+
+        if(mergeCount <= 1){
+            break;
+        }
+    }
+
+    My402ListElem* prev = anchor;
+    for(My402ListElem* cur = head; cur != NULL; cur = cur->next){
+        cur->prev = prev;
+        prev = cur;
+    }
+    prev->next = anchor;
+    anchor->next = head;
+    anchor->prev = prev;
+    addSortCounts(comparisons, swaps);
+}
+
+void MergeSortList(My402List* pList, int num_items){
+    if(My402ListLength(pList) != num_items){
+        fprintf(stderr, "List length is not %1d in MergeSortList().\n", num_items);
+        exit(1);
+    }
+    MergeSortLinks(pList);
+    checkDuplicateTime(pList);
+}
+
+int compareHeads(My402ListElem* elem1, int list1, My402ListElem* elem2, int list2){
+    long time1 = ((My402ListElemObj*)elem1->obj)->timestamp;
+    long time2 = ((My402ListElemObj*)elem2->obj)->timestamp;
+    if(time1 != time2){
+        return time1 < time2 ? -1 : 1;
+    }
+    return list1 - list2;
+}
+
+/* returns the number of comparisons made */
+int siftDownHeads(My402ListElem* heads[], int heap[], int heapSize, int index){
+    int comparisons = 0;
+    while(TRUE){
+        int smallest = index;
+        int left = index * 2 + 1;
+        int right = left + 1;
+        if(left < heapSize && (comparisons++, compareHeads(heads[heap[left]], heap[left], heads[heap[smallest]], heap[smallest]) < 0)){
+            smallest = left;
+        }
+        if(right < heapSize && (comparisons++, compareHeads(heads[heap[right]], heap[right], heads[heap[smallest]], heap[smallest]) < 0)){
+            smallest = right;
+        }
+        if(smallest == index){
+            return comparisons;
+        }
+        int temp = heap[index];
+        heap[index] = heap[smallest];
+        heap[smallest] = temp;
+        index = smallest;
+    }
+}
+
+/*
+ * k-way merge of lists already sorted on timestamp into the empty list out,
+ * using a binary heap of list heads. Ties go to the lower-numbered list, so
+ * if lists[] are consecutive pieces of one input the merge is stable. The
+ * elems are relinked, not copied; pooled lists hand their chunks to out.
+ */
+void MergeSortedLists(My402List* out, My402List* lists[], int numLists){
+    My402ListElem** heads = (My402ListElem**)malloc(sizeof(My402ListElem*) * numLists);
+    int* heap = (int*)malloc(sizeof(int) * numLists);
+    if(heads == NULL || heap == NULL){
+        fprintf(stderr, "Error malloc in MergeSortedLists().\n");
+        exit(1);
+    }
+    int heapSize = 0;
+    for(int a = 0; a < numLists; a++){
+        heads[a] = My402ListFirst(lists[a]);
+        if(heads[a] != NULL){
+            lists[a]->anchor.prev->next = NULL;
+            heap[heapSize++] = a;
+        }
+    }
+    long long comparisons = 0, swaps = 0;
+    for(int a = heapSize / 2 - 1; a >= 0; a--){
+        comparisons += siftDownHeads(heads, heap, heapSize, a);
+    }
+
+    My402ListElem* anchor = &out->anchor;
+    My402ListElem* prev = anchor;
+    int count = 0;
+    while(heapSize > 0){
+        int top = heap[0];
+        My402ListElem* elem = heads[top];
+        heads[top] = elem->next;
+        if(heads[top] == NULL){
+            heap[0] = heap[--heapSize];
+        }
+        comparisons += siftDownHeads(heads, heap, heapSize, 0);
+        swaps++;
+
+        elem->prev = prev;
+        prev->next = elem;
+        prev = elem;
+        count++;
+    }
+    if(count > 0){
+        prev->next = anchor;
+        anchor->prev = prev;
+    }
+    out->num_members = count;
+
+    for(int a = 0; a < numLists; a++){
+        My402ListAdoptPool(out, lists[a]);
+    }
+    free(heads);
+    free(heap);
+    addSortCounts(comparisons, swaps);
+}
+
+void checkDuplicateTime(My402List* pList){
+    for(My402ListElem* elem = My402ListFirst(pList); elem != NULL; elem = My402ListNext(pList, elem)){
+        My402ListElem* next_elem = My402ListNext(pList, elem);
+        if(next_elem == NULL){
+            break;
+        }
+        My402ListElemObj* curObj = (My402ListElemObj*)(elem->obj);
+        My402ListElemObj* nextObj = (My402ListElemObj*)(next_elem->obj);
+        if(curObj->timestamp == nextObj->timestamp){
+            fprintf(stderr, "line%d and %d, field: time, there are two identical timestamps.\n", curObj->lineNum, nextObj->lineNum);
+            exit(1);
+        }
+    }
+}
+
+/* moves column[keys[a] & 0xffffffff] to position a for every row */
+#define GATHER_COLUMN(type, column, keys, numRows) \
+    do{ \
+        type* sorted = (type*)malloc(sizeof(type) * (numRows)); \
+        if(sorted == NULL){ \
+            fprintf(stderr, "Error malloc in GATHER_COLUMN.\n"); \
+            exit(1); \
+        } \
+        for(int a = 0; a < (numRows); a++){ \
+            sorted[a] = (column)[(keys)[a] & 0xffffffffULL]; \
+        } \
+        free(column); \
+        (column) = sorted; \
+    }while(0)
+
+/*
+ * Stable bottom-up merge sort of the ledger rows on timestamp. The sort runs
+ * on one array of (timestamp << 32 | row) keys, which are all distinct, and
+ * then each column is gathered into the sorted order once. Duplicate
+ * timestamps are left for checkLedgerDuplicateTime().
+ */
+void MergeSortLedger(My402Ledger* ledger){
+    int numRows = ledger->num_rows;
+    if(numRows < 2){
+        return;
+    }
+    unsigned long long* keys = (unsigned long long*)malloc(sizeof(unsigned long long) * numRows);
+    unsigned long long* temp = (unsigned long long*)malloc(sizeof(unsigned long long) * numRows);
+    if(keys == NULL || temp == NULL){
+        fprintf(stderr, "Error malloc in MergeSortLedger().\n");
+        exit(1);
+    }
+    for(int a = 0; a < numRows; a++){
+        keys[a] = ((unsigned long long)ledger->timestamp[a] << 32) | (unsigned int)a;
+    }
+
+    long long comparisons = 0, swaps = 0;
+    for(int width = 1; width < numRows; width *= 2){
+        for(int left = 0; left < numRows; left += 2 * width){
+            int mid = min(left + width, numRows);
+            int right = min(left + 2 * width, numRows);
+            int a = left, b = mid, out = left;
+            while(a < mid && b < right){
+                temp[out++] = keys[a] < keys[b] ? keys[a++] : keys[b++];
+            }
+            comparisons += out - left;
+            while(a < mid){
+                temp[out++] = keys[a++];
+            }
+            while(b < right){
+                temp[out++] = keys[b++];
+            }
+        }
+        unsigned long long* swap = keys;
+        keys = temp;
+        temp = swap;
+        swaps += numRows;
+    }
+    addSortCounts(comparisons, swaps);
+
+    GATHER_COLUMN(unsigned int, ledger->timestamp, keys, numRows);
+    GATHER_COLUMN(int, ledger->amount, keys, numRows);
+    GATHER_COLUMN(int, ledger->lineNum, keys, numRows);
+    GATHER_COLUMN(long long, ledger->descOffset, keys, numRows);
+    ledger->capacity = numRows;
+    free(keys);
+    free(temp);
+}
+
+/*
+ * LSD radix sort of the ledger rows on timestamp, one byte per pass over
+ * (timestamp << 32 | row) keys. Passes where every key has the same byte
+ * are skipped. The scatter is stable, so equal timestamps stay in row
+ * order and end up next to each other; the last pass that runs compares
+ * each key with the one just before it in its bucket to find duplicates.
+ * With checkDuplicates the smallest duplicated timestamp is reported, as
+ * checkLedgerDuplicateTime() would.
+ */
+void RadixSortLedger(My402Ledger* ledger, int checkDuplicates){
+    int numRows = ledger->num_rows;
+    if(numRows < 2){
+        return;
+    }
+    unsigned long long* keys = (unsigned long long*)malloc(sizeof(unsigned long long) * numRows);
+    unsigned long long* temp = (unsigned long long*)malloc(sizeof(unsigned long long) * numRows);
+    if(keys == NULL || temp == NULL){
+        fprintf(stderr, "Error malloc in RadixSortLedger().\n");
+        exit(1);
+    }
+    int counts[4][256];
+    memset(counts, 0, sizeof(counts));
+    for(int a = 0; a < numRows; a++){
+        unsigned int timestamp = ledger->timestamp[a];
+        keys[a] = ((unsigned long long)timestamp << 32) | (unsigned int)a;
+        counts[0][timestamp & 0xff]++;
+        counts[1][(timestamp >> 8) & 0xff]++;
+        counts[2][(timestamp >> 16) & 0xff]++;
+        counts[3][timestamp >> 24]++;
+    }
+
+    int lastPass = -1;
+    for(int pass = 0; pass < 4; pass++){
+        if(counts[pass][(ledger->timestamp[0] >> (pass * 8)) & 0xff] != numRows){
+            lastPass = pass;
+        }
+    }
+
+    int dupFound = FALSE;
+    unsigned long long dupKey1 = 0, dupKey2 = 0;
+    for(int pass = 0; pass <= lastPass; pass++){
+        int shift = 32 + pass * 8;
+        if(counts[pass][(keys[0] >> shift) & 0xff] == numRows){
+            continue;
+        }
+        int offsets[256];
+        int start[256];
+        int total = 0;
+        for(int b = 0; b < 256; b++){
+            offsets[b] = total;
+            start[b] = total;
+            total += counts[pass][b];
+        }
+        if(pass < lastPass || !checkDuplicates){
+            for(int a = 0; a < numRows; a++){
+                temp[offsets[(keys[a] >> shift) & 0xff]++] = keys[a];
+            }
+        }
+        else{
+            for(int a = 0; a < numRows; a++){
+                unsigned long long key = keys[a];
+                int bucket = (key >> shift) & 0xff;
+                int pos = offsets[bucket]++;
+                if(pos > start[bucket] && (temp[pos - 1] >> 32) == (key >> 32) && (!dupFound || key < dupKey2)){
+                    dupFound = TRUE;
+                    dupKey1 = temp[pos - 1];
+                    dupKey2 = key;
+                }
+                temp[pos] = key;
+            }
+        }
+        unsigned long long* swap = keys;
+        keys = temp;
+        temp = swap;
+        addSortCounts(0, numRows);
+    }
+    if(checkDuplicates && lastPass < 0){
+        /* every timestamp is the same */
+        dupFound = TRUE;
+        dupKey1 = keys[0];
+        dupKey2 = keys[1];
+    }
+    if(dupFound){
+        fprintf(stderr, "line%d and %d, field: time, there are two identical timestamps.\n", ledger->lineNum[dupKey1 & 0xffffffffULL], ledger->lineNum[dupKey2 & 0xffffffffULL]);
+        exit(1);
+    }
+
+    GATHER_COLUMN(unsigned int, ledger->timestamp, keys, numRows);
+    GATHER_COLUMN(int, ledger->amount, keys, numRows);
+    GATHER_COLUMN(int, ledger->lineNum, keys, numRows);
+    GATHER_COLUMN(long long, ledger->descOffset, keys, numRows);
+    ledger->capacity = numRows;
+    free(keys);
+    free(temp);
+}
+
+int compareLedgerHeads(My402Ledger* ledgers[], int heads[], int ledger1, int ledger2){
+    unsigned int time1 = ledgers[ledger1]->timestamp[heads[ledger1]];
+    unsigned int time2 = ledgers[ledger2]->timestamp[heads[ledger2]];
+    if(time1 != time2){
+        return time1 < time2 ? -1 : 1;
+    }
+    return ledger1 - ledger2;
+}
+
+/* returns the number of comparisons made */
+int siftDownLedgerHeads(My402Ledger* ledgers[], int heads[], int heap[], int heapSize, int index){
+    int comparisons = 0;
+    while(TRUE){
+        int smallest = index;
+        int left = index * 2 + 1;
+        int right = left + 1;
+        if(left < heapSize && (comparisons++, compareLedgerHeads(ledgers, heads, heap[left], heap[smallest]) < 0)){
+            smallest = left;
+        }
+        if(right < heapSize && (comparisons++, compareLedgerHeads(ledgers, heads, heap[right], heap[smallest]) < 0)){
+            smallest = right;
+        }
+        if(smallest == index){
+            return comparisons;
+        }
+        int temp = heap[index];
+        heap[index] = heap[smallest];
+        heap[smallest] = temp;
+        index = smallest;
+    }
+}
+
+/*
+ * k-way merge of ledgers already sorted on timestamp, appending the rows to
+ * out. Ties go to the lower-numbered ledger, as in MergeSortedLists().
+ */
+void MergeSortedLedgers(My402Ledger* out, My402Ledger* ledgers[], int numLedgers){
+    int* heads = (int*)malloc(sizeof(int) * numLedgers);
+    int* heap = (int*)malloc(sizeof(int) * numLedgers);
+    if(heads == NULL || heap == NULL){
+        fprintf(stderr, "Error malloc in MergeSortedLedgers().\n");
+        exit(1);
+    }
+    int heapSize = 0;
+    int firstRow = out->num_rows;
+    for(int a = 0; a < numLedgers; a++){
+        heads[a] = 0;
+        if(ledgers[a]->num_rows > 0){
+            heap[heapSize++] = a;
+        }
+    }
+    long long comparisons = 0;
+    for(int a = heapSize / 2 - 1; a >= 0; a--){
+        comparisons += siftDownLedgerHeads(ledgers, heads, heap, heapSize, a);
+    }
+
+    while(heapSize > 0){
+        int top = heap[0];
+        if(!My402LedgerAppendRow(out, ledgers[top], heads[top])){
+            fprintf(stderr, "Error malloc in MergeSortedLedgers().\n");
+            exit(1);
+        }
+        heads[top]++;
+        if(heads[top] >= ledgers[top]->num_rows){
+            heap[0] = heap[--heapSize];
+        }
+        comparisons += siftDownLedgerHeads(ledgers, heads, heap, heapSize, 0);
+    }
+    free(heads);
+    free(heap);
+    addSortCounts(comparisons, out->num_rows - firstRow);
+}
+
+void checkLedgerDuplicateTime(My402Ledger* ledger){
+    for(int a = 1; a < ledger->num_rows; a++){
+        if(ledger->timestamp[a - 1] == ledger->timestamp[a]){
+            fprintf(stderr, "line%d and %d, field: time, there are two identical timestamps.\n", ledger->lineNum[a - 1], ledger->lineNum[a]);
+            exit(1);
+        }
+    }
+}
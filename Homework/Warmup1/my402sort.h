@@ -0,0 +1,28 @@
+#ifndef _MY402SORT_H_
+#define _MY402SORT_H_
+
+#include "my402list.h"
+#include "my402ledger.h"
+
+/*
+ * Running totals over all sorts and merges, for warmup1 --stats. A swap is
+ * an exchange in bubble sort or a heap, or an element move in a merge or
+ * radix pass.
+ */
+extern long long My402SortComparisons;
+extern long long My402SortSwaps;
+
+extern void BubbleForward(My402List*, My402ListElem**, My402ListElem**);
+extern void BubbleSortForwardList(My402List*, int);
+
+extern void MergeSortLinks(My402List*);
+extern void MergeSortList(My402List*, int);
+extern void MergeSortedLists(My402List*, My402List**, int);
+extern void checkDuplicateTime(My402List*);
+
+extern void MergeSortLedger(My402Ledger*);
+extern void RadixSortLedger(My402Ledger*, int);
+extern void MergeSortedLedgers(My402Ledger*, My402Ledger**, int);
+extern void checkLedgerDuplicateTime(My402Ledger*);
+
+#endif
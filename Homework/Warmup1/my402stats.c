@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "my402stats.h"
+#include "my402sort.h"
+
+int My402StatsEnabled = FALSE;
+long long My402StatsLines = 0;
+long long My402StatsBytes = 0;
+long long My402StatsMallocs = 0;
+
+static const char* statsCommand = NULL;
+static struct timespec statsStart;
+static struct timespec phaseStart;
+static long long phaseMallocs = 0;
+static long long phaseComparisons = 0;
+static long long phaseSwaps = 0;
+static My402StatsPhase phases[MAX_STATS_PHASES];
+static int numPhases = 0;
+
+/*
+ * warmup1 is linked with --wrap=malloc,--wrap=calloc,--wrap=realloc, so
+ * every allocation made by its own objects goes through these.
+ */
+void* __real_malloc(size_t);
+void* __real_calloc(size_t, size_t);
+void* __real_realloc(void*, size_t);
+
+void* __wrap_malloc(size_t size){
+    __atomic_fetch_add(&My402StatsMallocs, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+    __atomic_fetch_add(&My402StatsMallocs, 1, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size){
+    __atomic_fetch_add(&My402StatsMallocs, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+static long long elapsedNanos(struct timespec* start, struct timespec* end){
+    return (end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec);
+}
+
+void My402StatsStart(const char* command){
+    statsCommand = command;
+    if(My402StatsEnabled){
+        clock_gettime(CLOCK_MONOTONIC, &statsStart);
+        phaseStart = statsStart;
+    }
+    phaseMallocs = My402StatsMallocs;
+    phaseComparisons = My402SortComparisons;
+    phaseSwaps = My402SortSwaps;
+}
+
+/* a phase that is done more than once is added up under its first entry */
+void My402StatsPhaseDone(const char* name){
+    if(!My402StatsEnabled){
+        return;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    My402StatsPhase* phase = NULL;
+    for(int a = 0; a < numPhases; a++){
+        if(strcmp(phases[a].name, name) == 0){
+            phase = &phases[a];
+        }
+    }
+    if(phase == NULL && numPhases < MAX_STATS_PHASES){
+        phase = &phases[numPhases++];
+        memset(phase, 0, sizeof(My402StatsPhase));
+        phase->name = name;
+    }
+    if(phase != NULL){
+        phase->nanos += elapsedNanos(&phaseStart, &now);
+        phase->mallocs += My402StatsMallocs - phaseMallocs;
+        phase->comparisons += My402SortComparisons - phaseComparisons;
+        phase->swaps += My402SortSwaps - phaseSwaps;
+    }
+    phaseStart = now;
+    phaseMallocs = My402StatsMallocs;
+    phaseComparisons = My402SortComparisons;
+    phaseSwaps = My402SortSwaps;
+}
+
+/* one line of key=value pairs on stderr, durations in microseconds */
+void My402StatsPrint(){
+    if(!My402StatsEnabled){
+        return;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    fprintf(stderr, "warmup1-stats command=%s lines=%lld bytes=%lld", statsCommand, My402StatsLines, My402StatsBytes);
+    for(int a = 0; a < numPhases; a++){
+        My402StatsPhase* phase = &phases[a];
+        fprintf(stderr, " %s_us=%lld %s_mallocs=%lld %s_comparisons=%lld %s_swaps=%lld", phase->name, phase->nanos / 1000, phase->name, phase->mallocs,
+                phase->name, phase->comparisons, phase->name, phase->swaps);
+    }
+    fprintf(stderr, " total_us=%lld mallocs=%lld comparisons=%lld swaps=%lld\n", elapsedNanos(&statsStart, &now) / 1000, My402StatsMallocs, My402SortComparisons,
+            My402SortSwaps);
+}
@@ -0,0 +1,32 @@
+#ifndef _MY402STATS_H_
+#define _MY402STATS_H_
+
+#include "cs402.h"
+
+#define MAX_STATS_PHASES 8
+
+/*
+ * Opt-in run statistics for warmup1 --stats. A phase ends, and the next one
+ * starts, at each My402StatsPhaseDone() call; its wall time comes from
+ * CLOCK_MONOTONIC and its malloc, comparison and swap counts are the
+ * growth of the global counters since the previous call. Counters are
+ * always kept, the clock is only read when stats are enabled.
+ */
+typedef struct tagMy402StatsPhase {
+    const char *name;
+    long long nanos;
+    long long mallocs;
+    long long comparisons;
+    long long swaps;
+} My402StatsPhase;
+
+extern int My402StatsEnabled;
+extern long long My402StatsLines;
+extern long long My402StatsBytes;
+extern long long My402StatsMallocs;
+
+extern void My402StatsStart(const char*);
+extern void My402StatsPhaseDone(const char*);
+extern void My402StatsPrint();
+
+#endif /*_MY402STATS_H_*/
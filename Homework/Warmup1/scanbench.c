@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include "my402scan.h"
+
+int gnRows = 100000;
+int gnRounds = 20;
+
+void Usage(){
+    fprintf(stderr, "usage: scanbench [-rows=positive_integer] [-rounds=positive_integer]\n");
+    exit(1);
+}
+
+void ProcessOptions(int argc, char *argv[]){
+    for(int a = 1; a < argc; a++){
+        if(strncmp(argv[a], "-rows=", 6) == 0){
+            if(sscanf(&argv[a][6], "%d", &gnRows) != 1 || gnRows <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-rounds=", 8) == 0){
+            if(sscanf(&argv[a][8], "%d", &gnRounds) != 1 || gnRounds <= 0){
+                Usage();
+            }
+        }
+        else{
+            Usage();
+        }
+    }
+}
+
+/* cycle counter where there is one, nanoseconds otherwise */
+unsigned long long readCycles(){
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/* tfile-shaped lines with descriptions of 1 to 80 chars */
+char* createLines(int rows, int* lineLens, long long* totalBytes){
+    char* data = (char*)malloc((long long)rows * 128);
+    if(data == NULL){
+        fprintf(stderr, "Error malloc in createLines.\n");
+        exit(1);
+    }
+    long long pos = 0;
+    srand48(1);
+    for(int a = 0; a < rows; a++){
+        int descLen = 1 + (int)(drand48() * 80);
+        int len = sprintf(data + pos, "%c\t%ld\t%ld.%02ld\t", drand48() < 0.5 ? '+' : '-', 1000000000L + a, (long)(drand48() * 9999999), (long)(drand48() * 100));
+        for(int b = 0; b < descLen; b++){
+            data[pos + len + b] = 'a' + (b % 26);
+        }
+        len += descLen;
+        data[pos + len++] = '\n';
+        lineLens[a] = len;
+        pos += len;
+    }
+    *totalBytes = pos;
+    return data;
+}
+
+void runBench(const char* name, char* data, int* lineLens, long long totalBytes){
+    if(My402ScanInit(name) == NULL){
+        fprintf(stdout, "%-8s %14s\n", name, "unsupported");
+        return;
+    }
+    My402LineScan scan;
+    unsigned long long checksum = 0;
+    unsigned long long start = readCycles();
+    for(int round = 0; round < gnRounds; round++){
+        long long pos = 0;
+        for(int a = 0; a < gnRows; a++){
+            My402ScanLine(data + pos, lineLens[a], &scan);
+            checksum += scan.tabCount + scan.space[0] + scan.nonDigit[0];
+            pos += lineLens[a];
+        }
+    }
+    unsigned long long cycles = readCycles() - start;
+    double bytes = (double)totalBytes * gnRounds;
+    fprintf(stdout, "%-8s %14.3f %14llu\n", name, bytes / (double)(cycles > 0 ? cycles : 1), checksum);
+}
+
+int main(int argc, char *argv[]){
+    ProcessOptions(argc, argv);
+
+    int* lineLens = (int*)malloc(sizeof(int) * gnRows);
+    long long totalBytes = 0;
+    char* data = createLines(gnRows, lineLens, &totalBytes);
+
+#if defined(__x86_64__)
+    fprintf(stdout, "%-8s %14s %14s\n", "scanner", "bytes/cycle", "checksum");
+#else
+    fprintf(stdout, "%-8s %14s %14s\n", "scanner", "bytes/ns", "checksum");
+#endif
+    runBench("scalar", data, lineLens, totalBytes);
+    runBench("sse2", data, lineLens, totalBytes);
+    runBench("avx2", data, lineLens, totalBytes);
+
+    free(data);
+    free(lineLens);
+    return 0;
+}
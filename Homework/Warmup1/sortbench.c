@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "my402list.h"
+#include "my402listobj.h"
+#include "my402ledger.h"
+#include "my402sort.h"
+
+int gnSeed = 0;
+int gnMinRows = 1000;
+int gnMaxRows = 10000000;
+int gnBubbleMaxRows = 10000;
+
+void Usage(){
+    fprintf(stderr, "usage: sortbench [-seed=positive_integer] [-min=rows] [-max=rows] [-bubblemax=rows]\n");
+    exit(1);
+}
+
+void ProcessOptions(int argc, char *argv[]){
+    for(int a = 1; a < argc; a++){
+        if(strncmp(argv[a], "-seed=", 6) == 0){
+            if(sscanf(&argv[a][6], "%d", &gnSeed) != 1 || gnSeed <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-min=", 5) == 0){
+            if(sscanf(&argv[a][5], "%d", &gnMinRows) != 1 || gnMinRows <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-max=", 5) == 0){
+            if(sscanf(&argv[a][5], "%d", &gnMaxRows) != 1 || gnMaxRows <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-bubblemax=", 11) == 0){
+            if(sscanf(&argv[a][11], "%d", &gnBubbleMaxRows) != 1 || gnBubbleMaxRows < 0){
+                Usage();
+            }
+        }
+        else{
+            Usage();
+        }
+    }
+}
+
+double elapsedMS(struct timeval start, struct timeval end){
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_usec - start.tv_usec) / 1e3;
+}
+
+/* distinct timestamps in random order, like a shuffled statement file */
+My402ListElemObj* createObjs(int rows){
+    My402ListElemObj* objs = (My402ListElemObj*)malloc(sizeof(My402ListElemObj) * rows);
+    if(objs == NULL){
+        fprintf(stderr, "Error malloc in createObjs.\n");
+        exit(1);
+    }
+    memset(objs, 0, sizeof(My402ListElemObj) * rows);
+    for(int a = 0; a < rows; a++){
+        objs[a].timestamp = 1000000000L + a;
+        objs[a].lineNum = a + 1;
+    }
+    for(int a = rows - 1; a > 0; a--){
+        int b = (int)(drand48() * (a + 1));
+        long temp = objs[a].timestamp;
+        objs[a].timestamp = objs[b].timestamp;
+        objs[b].timestamp = temp;
+    }
+    return objs;
+}
+
+void fillList(My402List* pList, My402ListElemObj* objs, int rows){
+    My402ListInit(pList);
+    for(int a = 0; a < rows; a++){
+        if(!My402ListAppend(pList, &objs[a])){
+            exit(1);
+        }
+    }
+}
+
+void checkSorted(My402List* pList, const char* name){
+    long prev = -1;
+    for(My402ListElem* elem = My402ListFirst(pList); elem != NULL; elem = My402ListNext(pList, elem)){
+        long cur = ((My402ListElemObj*)elem->obj)->timestamp;
+        if(cur <= prev){
+            fprintf(stderr, "%s produced an unsorted list.\n", name);
+            exit(1);
+        }
+        prev = cur;
+    }
+}
+
+void fillLedger(My402Ledger* ledger, My402ListElemObj* objs, int rows){
+    My402LedgerInit(ledger);
+    for(int a = 0; a < rows; a++){
+        if(!My402LedgerAppend(ledger, (unsigned int)objs[a].timestamp, 0, objs[a].lineNum, "x", 1)){
+            exit(1);
+        }
+    }
+}
+
+void checkLedgerSorted(My402Ledger* ledger, const char* name){
+    for(int a = 1; a < ledger->num_rows; a++){
+        if(ledger->timestamp[a] <= ledger->timestamp[a - 1]){
+            fprintf(stderr, "%s produced an unsorted ledger.\n", name);
+            exit(1);
+        }
+    }
+}
+
+void runBench(int rows){
+    My402ListElemObj* objs = createObjs(rows);
+    My402List myList;
+    My402Ledger ledger;
+    struct timeval start, end;
+
+    fillLedger(&ledger, objs, rows);
+    gettimeofday(&start, NULL);
+    RadixSortLedger(&ledger, TRUE);
+    gettimeofday(&end, NULL);
+    checkLedgerSorted(&ledger, "RadixSortLedger");
+    double radixMS = elapsedMS(start, end);
+    My402LedgerFree(&ledger);
+
+    fillLedger(&ledger, objs, rows);
+    gettimeofday(&start, NULL);
+    MergeSortLedger(&ledger);
+    checkLedgerDuplicateTime(&ledger);
+    gettimeofday(&end, NULL);
+    checkLedgerSorted(&ledger, "MergeSortLedger");
+    double ledgerMS = elapsedMS(start, end);
+    My402LedgerFree(&ledger);
+
+    fillList(&myList, objs, rows);
+    gettimeofday(&start, NULL);
+    MergeSortList(&myList, rows);
+    gettimeofday(&end, NULL);
+    checkSorted(&myList, "MergeSortList");
+    double mergeMS = elapsedMS(start, end);
+    My402ListUnlinkAll(&myList);
+
+    if(rows <= gnBubbleMaxRows){
+        fillList(&myList, objs, rows);
+        gettimeofday(&start, NULL);
+        BubbleSortForwardList(&myList, rows);
+        gettimeofday(&end, NULL);
+        checkSorted(&myList, "BubbleSortForwardList");
+        double bubbleMS = elapsedMS(start, end);
+        My402ListUnlinkAll(&myList);
+
+        fprintf(stdout, "%10d %14.3f %14.3f %14.3f %14.3f %10.1fx\n", rows, radixMS, ledgerMS, mergeMS, bubbleMS, radixMS > 0 ? bubbleMS / radixMS : 0);
+    }
+    else{
+        fprintf(stdout, "%10d %14.3f %14.3f %14.3f %14s %11s\n", rows, radixMS, ledgerMS, mergeMS, "skipped", "-");
+    }
+    fflush(stdout);
+    free(objs);
+}
+
+int main(int argc, char *argv[]){
+    ProcessOptions(argc, argv);
+    if(gnSeed > 0){
+        srand48(gnSeed);
+    }
+    else{
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        srand48(((long)tv.tv_sec) + ((long)tv.tv_usec));
+    }
+
+    fprintf(stdout, "%10s %14s %14s %14s %14s %11s\n", "rows", "radix(ms)", "ledger(ms)", "list(ms)", "bubble(ms)", "speedup");
+    for(long rows = gnMinRows; rows <= gnMaxRows; rows *= 10){
+        runBench((int)rows);
+    }
+    return 0;
+}
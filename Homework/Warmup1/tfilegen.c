@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cs402.h"
+
+#define ORDER_SORTED 0
+#define ORDER_REVERSE 1
+#define ORDER_RANDOM 2
+#define ORDER_CLUSTERED 3
+
+/* rows in one run of consecutive timestamps for -order=clustered */
+#define CLUSTER_ROWS 1024
+
+int gnRows = 100000;
+int gnOrder = ORDER_RANDOM;
+int gnMinDesc = 1;
+int gnMaxDesc = 40;
+int gnMaxAmount = 9999999;
+int gnSeed = 1;
+
+void Usage(){
+    fprintf(stderr, "usage: tfilegen [-rows=positive_integer] [-order=sorted|reverse|random|clustered] [-mindesc=chars] [-maxdesc=chars] [-maxamount=dollars] [-seed=positive_integer]\n");
+    exit(1);
+}
+
+void ProcessOptions(int argc, char *argv[]){
+    for(int a = 1; a < argc; a++){
+        if(strncmp(argv[a], "-rows=", 6) == 0){
+            if(sscanf(&argv[a][6], "%d", &gnRows) != 1 || gnRows <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-order=", 7) == 0){
+            const char* order = &argv[a][7];
+            if(strcmp(order, "sorted") == 0){
+                gnOrder = ORDER_SORTED;
+            }
+            else if(strcmp(order, "reverse") == 0){
+                gnOrder = ORDER_REVERSE;
+            }
+            else if(strcmp(order, "random") == 0){
+                gnOrder = ORDER_RANDOM;
+            }
+            else if(strcmp(order, "clustered") == 0){
+                gnOrder = ORDER_CLUSTERED;
+            }
+            else{
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-mindesc=", 9) == 0){
+            if(sscanf(&argv[a][9], "%d", &gnMinDesc) != 1 || gnMinDesc <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-maxdesc=", 9) == 0){
+            if(sscanf(&argv[a][9], "%d", &gnMaxDesc) != 1 || gnMaxDesc <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-maxamount=", 11) == 0){
+            if(sscanf(&argv[a][11], "%d", &gnMaxAmount) != 1 || gnMaxAmount < 0 || gnMaxAmount > 9999999){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-seed=", 6) == 0){
+            if(sscanf(&argv[a][6], "%d", &gnSeed) != 1 || gnSeed <= 0){
+                Usage();
+            }
+        }
+        else{
+            Usage();
+        }
+    }
+    /* the whole line, with type, time, amount and tabs, must fit in 1024 chars */
+    if(gnMinDesc > gnMaxDesc || gnMaxDesc > 999){
+        Usage();
+    }
+    /* every row needs its own second before now */
+    if((long long)gnRows >= (long long)time(NULL)){
+        Usage();
+    }
+}
+
+void shuffle(unsigned int* values, int count){
+    for(int a = count - 1; a > 0; a--){
+        int b = (int)(drand48() * (a + 1));
+        unsigned int temp = values[a];
+        values[a] = values[b];
+        values[b] = temp;
+    }
+}
+
+/*
+ * Distinct timestamps, increasing from 1000000000 by 1 to 20 seconds, laid
+ * out in the requested order. The step shrinks when that many rows would run
+ * past the current time, and the start moves back when even steps of 1 would. Clustered keeps runs of CLUSTER_ROWS
+ * consecutive timestamps together but shuffles the runs, like branch files
+ * that were concatenated.
+ */
+unsigned int* createTimestamps(int rows){
+    unsigned int* timestamps = (unsigned int*)malloc(sizeof(unsigned int) * rows);
+    if(timestamps == NULL){
+        fprintf(stderr, "Error malloc in createTimestamps.\n");
+        exit(1);
+    }
+    unsigned int now = (unsigned int)time(NULL);
+    unsigned int timestamp = 1000000000;
+    if(now - timestamp < (unsigned int)rows){
+        timestamp = now - rows;
+    }
+    unsigned int maxStep = (unsigned int)min(20, (now - timestamp) / rows);
+    for(int a = 0; a < rows; a++){
+        timestamps[a] = timestamp;
+        timestamp += 1 + (unsigned int)(drand48() * maxStep);
+    }
+    if(gnOrder == ORDER_REVERSE){
+        for(int a = 0, b = rows - 1; a < b; a++, b--){
+            unsigned int temp = timestamps[a];
+            timestamps[a] = timestamps[b];
+            timestamps[b] = temp;
+        }
+    }
+    else if(gnOrder == ORDER_RANDOM){
+        shuffle(timestamps, rows);
+    }
+    else if(gnOrder == ORDER_CLUSTERED){
+        int numClusters = (rows + CLUSTER_ROWS - 1) / CLUSTER_ROWS;
+        unsigned int* clusters = (unsigned int*)malloc(sizeof(unsigned int) * numClusters);
+        unsigned int* sorted = (unsigned int*)malloc(sizeof(unsigned int) * rows);
+        if(clusters == NULL || sorted == NULL){
+            fprintf(stderr, "Error malloc in createTimestamps.\n");
+            exit(1);
+        }
+        memcpy(sorted, timestamps, sizeof(unsigned int) * rows);
+        for(int a = 0; a < numClusters; a++){
+            clusters[a] = a;
+        }
+        shuffle(clusters, numClusters);
+        int row = 0;
+        for(int a = 0; a < numClusters; a++){
+            int start = clusters[a] * CLUSTER_ROWS;
+            int end = min(start + CLUSTER_ROWS, rows);
+            for(int b = start; b < end; b++){
+                timestamps[row++] = sorted[b];
+            }
+        }
+        free(clusters);
+        free(sorted);
+    }
+    return timestamps;
+}
+
+int main(int argc, char *argv[]){
+    ProcessOptions(argc, argv);
+    srand48(gnSeed);
+
+    unsigned int* timestamps = createTimestamps(gnRows);
+    char desc[1024];
+    for(int a = 0; a < gnRows; a++){
+        int descLen = gnMinDesc + (int)(drand48() * (gnMaxDesc - gnMinDesc + 1));
+        for(int b = 0; b < descLen; b++){
+            desc[b] = 'a' + (int)(drand48() * 26);
+        }
+        desc[descLen] = '\0';
+
+        long long cents = 1 + (long long)(drand48() * ((long long)gnMaxAmount * 100 + 99));
+        fprintf(stdout, "%c\t%u\t%lld.%02lld\t%s\n", drand48() < 0.5 ? '+' : '-', timestamps[a], cents / 100, cents % 100, desc);
+    }
+    free(timestamps);
+    return 0;
+}
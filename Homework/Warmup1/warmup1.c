@@ -2,127 +2,157 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
 
-#include "my402list.h"
-#include "my402listobj.h"
+#include "my402ledger.h"
+#include "my402input.h"
+#include "my402scan.h"
+#include "my402date.h"
+#include "my402sort.h"
+#include "my402merge.h"
+#include "my402stats.h"
 
-void checkLine(char line[], int lineLen, int lineNum){
-    if(lineLen > 1024){
-        fprintf(stderr, "line%d, field: line, the line length is larger than 1024.\n", lineNum);
-        exit(1);
-    }
-    int tabCount = 0;
-    for(int a = 0; a < lineLen; a++){
-        if(line[a] == '\t'){
-            tabCount++;
+typedef struct tagParseJob {
+    char *data;
+    long long start;
+    long long end;
+    int index;
+    int useRadix;
+    int *lineCounts;
+    pthread_barrier_t *barrier;
+    My402Ledger ledger;
+    int errorLine;
+    char errorMsg[128];
+} ParseJob;
+
+/* set once in main before any -j worker starts, then only read */
+long curTime;
+/* a later reading of the clock, kept per thread so checkTime never writes shared state */
+__thread long threadCurTime = 0;
+__thread ParseJob* curParseJob = NULL;
+
+/* lines in front of the input being parsed, only counted if an error is reported */
+char* lineNumPrefix = NULL;
+long long lineNumPrefixLen = 0;
+
+int countLines(char* data, long long start, long long end){
+    int count = 0;
+    long long pos = start;
+    while(pos < end){
+        char* newline = (char*)memchr(data + pos, '\n', end - pos);
+        count++;
+        if(newline == NULL){
+            break;
         }
+        pos = newline - data + 1;
+    }
+    return count;
+}
+
+
+/*
+ * Reports a bad input line. A parse thread cannot exit right away since an
+ * earlier chunk may still turn up an earlier bad line, so it records the
+ * error and stops; parseParallel() reports the first one.
+ */
+void lineError(int lineNum, const char* field, const char* reason){
+    if(curParseJob != NULL){
+        curParseJob->errorLine = lineNum;
+        snprintf(curParseJob->errorMsg, sizeof(curParseJob->errorMsg), "line%d, field: %s, %s\n", lineNum, field, reason);
+        pthread_exit(NULL);
+    }
+    if(lineNumPrefix != NULL){
+        lineNum += countLines(lineNumPrefix, 0, lineNumPrefixLen);
+    }
+    fprintf(stderr, "line%d, field: %s, %s\n", lineNum, field, reason);
+    exit(1);
+}
+
+void checkLine(int lineLen, int tabCount, int lineNum){
+    if(lineLen > 1024){
+        lineError(lineNum, "line", "the line length is larger than 1024.");
     }
     if(tabCount != 3){
-        fprintf(stderr, "line%d, field: line, the line does not have exactly 4 fields.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "line", "the line does not have exactly 4 fields.");
     }
 }
 
 void checkType(char type[], int typeLen, int lineNum){
     if(typeLen != 1){
-        fprintf(stderr, "line%d, field: type, the type does not have only 1 char.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "type", "the type does not have only 1 char.");
     }
     if(type[0] != '+' && type[0] != '-'){
-        fprintf(stderr, "line%d, field: type, the type should be + or -.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "type", "the type should be + or -.");
     }
 }
 
-long checkTime(char myTime[], int myTimeLen, int lineNum){
+long checkTime(char myTime[], int myTimeLen, int nonDigitCount, int lineNum){
     if(myTimeLen < 1 || myTimeLen >= 11){
-        fprintf(stderr, "line%d, field: time, the time length should be >= 1 and <= 10.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "time", "the time length should be >= 1 and <= 10.");
     }
-    for(int a = 0; a < myTimeLen; a++){
-        if(myTime[a] < '0' || myTime[a] > '9'){
-            fprintf(stderr, "line%d, field: time, the time has non-digit char.\n", lineNum);
-            exit(1);
-        }
+    if(nonDigitCount > 0){
+        lineError(lineNum, "time", "the time has non-digit char.");
     }
     if(myTime[0] == '0'){
-        fprintf(stderr, "line%d, field: time, the time first digit is 0.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "time", "the time first digit is 0.");
     }
-    long long inputTime = atoll(myTime);
-    if(inputTime < 0 || inputTime > time(NULL)){
-        fprintf(stderr, "line%d, field: time, the time should not < 0 or > curTime.\n", lineNum);
-        exit(1);
+    long long inputTime = 0;
+    for(int a = 0; a < myTimeLen; a++){
+        inputTime = inputTime * 10 + (myTime[a] - '0');
+    }
+    if(inputTime > curTime && inputTime > threadCurTime){
+        threadCurTime = time(NULL);
+    }
+    if(inputTime < 0 || (inputTime > curTime && inputTime > threadCurTime)){
+        lineError(lineNum, "time", "the time should not < 0 or > curTime.");
     }
-    return atol(myTime);
+    return (long)inputTime;
 }
 
-long long checkAmount(char amount[], int amountLen, int lineNum){
+/* dotIndex is only meaningful when dotCount is 1; nonDigitCount excludes dots */
+long long checkAmount(char amount[], int amountLen, int dotCount, int dotIndex, int nonDigitCount, int lineNum){
     if(amountLen < 1){
-        fprintf(stderr, "line%d, field: amount, the amount length should be > 0.\n", lineNum);
-        exit(1);
-    }
-    int dotIndex = 0;
-    int dotCount = 0;
-    for(int a = 0; a < amountLen; a++){
-        if(amount[a] == '.'){
-            dotIndex = a;
-            dotCount++;
-        }
+        lineError(lineNum, "amount", "the amount length should be > 0.");
     }
     if(dotCount != 1){
-        fprintf(stderr, "line%d, field: amount, the amount does not have exactly only 1 dot.\n", lineNum);
-        exit(1);
-    }
-    for(int a = 0; a < dotIndex; a++){
-        if(amount[a] < '0' || amount[a] > '9'){
-            fprintf(stderr, "line%d, field: amount, the amount has non-digit char.\n", lineNum);
-            exit(1);
-        }
+        lineError(lineNum, "amount", "the amount does not have exactly only 1 dot.");
     }
-    for(int a = dotIndex + 1; a < amountLen; a++){
-        if(amount[a] < '0' || amount[a] > '9'){
-            fprintf(stderr, "line%d, field: amount, the amount has non-digit char.\n", lineNum);
-            exit(1);
-        }
+    if(nonDigitCount > 0){
+        lineError(lineNum, "amount", "the amount has non-digit char.");
     }
     if(dotIndex > 7){
-        fprintf(stderr, "line%d, field: amount, the amount number before dot has more than 7 digits.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "amount", "the amount number before dot has more than 7 digits.");
     }
     if(amountLen - 1 - dotIndex != 2){
-        fprintf(stderr, "line%d, field: amount, the amount number after dot does not have exactly only 2 digits.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "amount", "the amount number after dot does not have exactly only 2 digits.");
     }
-    char numPrevDot[16];
-    char numNextDot[16];
-    memset(numPrevDot, 0, 16);
-    memset(numNextDot, 0, 16);
+    long long numPrev = 0;
     for(int a = 0; a < dotIndex; a++){
-        numPrevDot[a] = amount[a];
-    }
-    for(int a = dotIndex + 1, b = 0; a < amountLen && b < 16; a++, b++){
-        numNextDot[b] = amount[a];
+        numPrev = numPrev * 10 + (amount[a] - '0');
     }
-    long long numPrev = atoll(numPrevDot);
-    long long numNext = atoll(numNextDot);
+    long long numNext = (amount[dotIndex + 1] - '0') * 10 + (amount[dotIndex + 2] - '0');
     if(numPrev > 0 || numNext > 0){
         if(dotIndex - 1 != 0 && amount[0] == '0'){
-            fprintf(stderr, "line%d, field: amount, the amount non-zero has leading 0.\n", lineNum);
-            exit(1);
+            lineError(lineNum, "amount", "the amount non-zero has leading 0.");
         }
     }
     else{
-        fprintf(stderr, "line%d, field: amount, the amount cannot be 0.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "amount", "the amount cannot be 0.");
     }
     return numPrev * 100 + numNext;
 }
 
-void checkDesc(char desc[], int descLen, int lineNum){
+/* returns the index of the first non-space char of the description */
+int checkDesc(char desc[], int descLen, int lineNum){
     if(descLen < 1){
-        fprintf(stderr, "line%d, field: desc, the description length should be > 0.\n", lineNum);
-        exit(1);
+        lineError(lineNum, "desc", "the description length should be > 0.");
     }
     int nonZeroIndex = 0;
     for(int a = 0; a < descLen; a++){
@@ -132,316 +162,1308 @@ void checkDesc(char desc[], int descLen, int lineNum){
         }
     }
     if(nonZeroIndex >= descLen){
-        fprintf(stderr, "line%d, field: desc, the description cannot be empty.\n", lineNum);
+        lineError(lineNum, "desc", "the description cannot be empty.");
+    }
+    return nonZeroIndex;
+}
+
+/*
+ * Splits a line the same way sscanf("%s %s %s %[^\n]") did: three
+ * whitespace-separated tokens, then the rest of the line after any leading
+ * whitespace. Field boundaries, tab count and digit/dot checks all come from
+ * the one My402ScanLine() pass over the line.
+ */
+void parseRecord(char line[], int lineLen, int lineNum, My402Record* record){
+    int fieldStart[4] = {0, 0, 0, 0};
+    int fieldLen[4] = {0, 0, 0, 0};
+    My402LineScan scan;
+    scan.tabCount = 0;
+
+    if(lineLen <= MAX_LINE_LEN){
+        My402ScanLine(line, lineLen, &scan);
+
+        int pos = 0;
+        for(int a = 0; a < 4; a++){
+            int start = My402ScanNext(scan.space, pos, lineLen, FALSE);
+            if(start >= lineLen){
+                break;
+            }
+            int end = My402ScanNext(scan.space, start, lineLen, TRUE);
+            if(a == 3){
+                end = line[lineLen - 1] == '\n' ? lineLen - 1 : lineLen;
+            }
+            fieldStart[a] = start;
+            fieldLen[a] = end - start;
+            pos = end;
+        }
+    }
+    char* field[4] = {&line[fieldStart[0]], &line[fieldStart[1]], &line[fieldStart[2]], &line[fieldStart[3]]};
+    int timeEnd = fieldStart[1] + fieldLen[1];
+    int amountEnd = fieldStart[2] + fieldLen[2];
+
+    checkLine(lineLen, scan.tabCount, lineNum);
+    checkType(field[0], fieldLen[0], lineNum);
+    long inputTime = checkTime(field[1], fieldLen[1], My402ScanCount(scan.nonDigit, fieldStart[1], timeEnd), lineNum);
+    int dotCount = My402ScanCount(scan.dot, fieldStart[2], amountEnd);
+    int dotIndex = My402ScanNext(scan.dot, fieldStart[2], amountEnd, TRUE) - fieldStart[2];
+    int amountNonDigitCount = My402ScanCount(scan.nonDigit, fieldStart[2], amountEnd) - dotCount;
+    long long myAmount = checkAmount(field[2], fieldLen[2], dotCount, dotIndex, amountNonDigitCount, lineNum);
+    int descStart = checkDesc(field[3], fieldLen[3], lineNum);
+
+    int descLen = min(fieldLen[3] - descStart, 24);
+    record->timestamp = (unsigned int)inputTime;
+    record->amount = field[0][0] == '-' ? -(int)myAmount : (int)myAmount;
+    record->lineNum = lineNum;
+    memcpy(record->desc, field[3] + descStart, descLen);
+    record->desc[descLen] = '\0';
+}
+
+void parseLine(char line[], int lineLen, int lineNum, My402Ledger* ledger){
+    My402Record record;
+    parseRecord(line, lineLen, lineNum, &record);
+    if(!My402LedgerAppend(ledger, record.timestamp, record.amount, lineNum, record.desc, strlen(record.desc))){
+        fprintf(stderr, "Error malloc in parseLine.\n");
         exit(1);
     }
-    char temp[25];
-    memset(temp, 0, sizeof(temp));
-    for(int a = nonZeroIndex, b = 0; a < descLen && b < 25; a++, b++){
-        temp[b] = desc[a];
-    }
-    strcpy(desc, temp);
-}
-
-void BubbleForward(My402List *pList, My402ListElem **pp_elem1, My402ListElem **pp_elem2)
-    /* (*pp_elem1) must be closer to First() than (*pp_elem2) */
-{
-    My402ListElem* elem1 = (*pp_elem1), *elem2 = (*pp_elem2);
-    void* obj1 = elem1->obj, *obj2 = elem2->obj;
-    My402ListElem* elem1prev = My402ListPrev(pList, elem1);
-/*  My402ListElem *elem1next=My402ListNext(pList, elem1); */
-/*  My402ListElem *elem2prev=My402ListPrev(pList, elem2); */
-    My402ListElem* elem2next = My402ListNext(pList, elem2);
-
-    My402ListUnlink(pList, elem1);
-    My402ListUnlink(pList, elem2);
-    if (elem1prev == NULL) {
-        (void)My402ListPrepend(pList, obj2);
-        *pp_elem1 = My402ListFirst(pList);
-    } 
-    else {
-        (void)My402ListInsertAfter(pList, obj2, elem1prev);
-        *pp_elem1 = My402ListNext(pList, elem1prev);
-    }
-    if (elem2next == NULL) {
-        (void)My402ListAppend(pList, obj1);
-        *pp_elem2 = My402ListLast(pList);
-    } 
-    else {
-        (void)My402ListInsertBefore(pList, obj1, elem2next);
-        *pp_elem2 = My402ListPrev(pList, elem2next);
-    }
-}
-
-void BubbleSortForwardList(My402List *pList, int num_items){
-    My402ListElem* elem = NULL;
-    int i = 0;
-
-    if (My402ListLength(pList) != num_items) {
-        fprintf(stderr, "List length is not %1d in BubbleSortForwardList().\n", num_items);
+}
+
+/* writes the 14-char amount column, e.g. "(  1,234.56)", into temp without a terminating '\0' */
+void transferFormat(long long money, char temp[]){
+    temp[0] = money < 0 ? '(' : ' ';
+    temp[13] = money < 0 ? ')' : ' ';
+    if(money <= -1000000000LL || money >= 1000000000LL){
+        memcpy(temp + 1, "?,???,???.??", 12);
+        return;
+    }
+    unsigned long long value = money < 0 ? -money : money;
+    unsigned long long whole = value / 100;
+    temp[12] = '0' + value % 10;
+    temp[11] = '0' + value / 10 % 10;
+    temp[10] = '.';
+    int index = 9;
+    int digits = 0;
+    do{
+        if(digits > 0 && digits % 3 == 0){
+            temp[index--] = ',';
+        }
+        temp[index--] = '0' + whole % 10;
+        whole /= 10;
+        digits++;
+    }while(whole > 0);
+    while(index >= 1){
+        temp[index--] = ' ';
+    }
+}
+
+void PrintTestLedger(My402Ledger* ledger){
+    My402DateCache dateCache;
+    My402DateInit(&dateCache);
+
+    for(int a = 0; a < ledger->num_rows; a++){
+        fprintf(stdout, "%d %s %s %u %d\n", ledger->lineNum[a], My402LedgerDesc(ledger, a), My402DateFormat(&dateCache, ledger->timestamp[a]), ledger->timestamp[a], ledger->amount[a]);
+    }
+    fprintf(stdout, "\n");
+}
+
+#define ROW_LEN 81
+#define OUTPUT_BUFFER_SIZE (ROW_LEN * 4096)
+
+char outputBuffer[OUTPUT_BUFFER_SIZE];
+int outputUsed = 0;
+
+void flushOutput(){
+    if(outputUsed > 0 && fwrite(outputBuffer, 1, outputUsed, stdout) != (size_t)outputUsed){
+        fprintf(stderr, "Error writing output.\n");
         exit(1);
     }
-    for (i = 0; i < num_items; i++) {
-        int j = 0, something_swapped = FALSE;
-        My402ListElem* next_elem = NULL;
+    outputUsed = 0;
+}
+
+/* copies at most width chars of str, stopping at its '\0' */
+void copyField(char* dst, const char* str, int width){
+    for(int a = 0; a < width && str[a] != '\0'; a++){
+        dst[a] = str[a];
+    }
+}
 
-        for (elem = My402ListFirst(pList), j = 0; j < num_items-i - 1; elem = next_elem, j++) {
-            My402ListElemObj* curObj = (My402ListElemObj*)(elem->obj);
-            long long cur_val = curObj->timestamp;
+char dashLine[ROW_LEN];
+char rowTemplate[ROW_LEN];
+My402DateCache tableDateCache;
+long long tableBalance = 0;
 
-            next_elem = My402ListNext(pList, elem);
-            My402ListElemObj* nextObj = (My402ListElemObj*)(next_elem->obj);
-            long long next_val = nextObj->timestamp;
+/* a row is the blank template with each field copied into its column */
+void formatRow(char* row, unsigned int timestamp, const char* desc, int amount, long long balance, My402DateCache* dateCache){
+    memcpy(row, rowTemplate, ROW_LEN);
+    copyField(row + 2, My402DateFormat(dateCache, timestamp), 15);
+    copyField(row + 20, desc, 24);
+    transferFormat(amount, row + 47);
+    transferFormat(balance, row + 64);
+}
 
-            if(cur_val == next_val){
-                fprintf(stderr, "line%d and %d, field: time, there are two identical timestamps.\n", curObj->lineNum, nextObj->lineNum);
-                exit(1);
-            }
+void printTableHeader(){
+    char secondLine[ROW_LEN];
 
-            if (cur_val > next_val) {
-                BubbleForward(pList, &elem, &next_elem);
-                something_swapped = TRUE;
-            }
+    int indexArray[] = {0, 18, 45, 62, 79};
+    memset(dashLine, '-', ROW_LEN - 1);
+    memset(rowTemplate, ' ', ROW_LEN - 1);
+    for(int a = 0; a < 5; a++){
+        dashLine[indexArray[a]] = '+';
+        rowTemplate[indexArray[a]] = '|';
+    }
+    dashLine[ROW_LEN - 1] = '\n';
+    rowTemplate[ROW_LEN - 1] = '\n';
+
+    memcpy(secondLine, rowTemplate, ROW_LEN);
+    memcpy(secondLine + 8, "Date", 4);
+    memcpy(secondLine + 20, "Description", 11);
+    memcpy(secondLine + 55, "Amount", 6);
+    memcpy(secondLine + 71, "Balance", 7);
+
+    memcpy(outputBuffer + outputUsed, dashLine, ROW_LEN);
+    memcpy(outputBuffer + outputUsed + ROW_LEN, secondLine, ROW_LEN);
+    memcpy(outputBuffer + outputUsed + 2 * ROW_LEN, dashLine, ROW_LEN);
+    outputUsed += 3 * ROW_LEN;
+
+    My402DateInit(&tableDateCache);
+    tableBalance = 0;
+}
+
+/* rows must come in sorted order, the balance is carried from row to row */
+void printTableRow(unsigned int timestamp, const char* desc, int amount){
+    if(outputUsed + ROW_LEN > OUTPUT_BUFFER_SIZE){
+        flushOutput();
+    }
+    tableBalance += amount;
+    formatRow(outputBuffer + outputUsed, timestamp, desc, amount, tableBalance, &tableDateCache);
+    outputUsed += ROW_LEN;
+}
+
+void printTableFooter(){
+    if(outputUsed + ROW_LEN > OUTPUT_BUFFER_SIZE){
+        flushOutput();
+    }
+    memcpy(outputBuffer + outputUsed, dashLine, ROW_LEN);
+    outputUsed += ROW_LEN;
+    flushOutput();
+}
+
+/* rows per job in each window of a parallel printTable() */
+#define FORMAT_WINDOW_ROWS 16384
+
+typedef struct tagFormatJob {
+    My402Ledger *ledger;
+    int start;
+    int end;
+    int index;
+    long long *blockSums;
+    long long carry;
+    char *output;
+    pthread_barrier_t *barrier;
+    My402DateCache dateCache;
+} FormatJob;
+
+/*
+ * One block of a window: sums its amounts, waits for the other blocks, then
+ * adds up the sums in front of it to get its starting balance and formats
+ * its rows into its own part of the window buffer.
+ */
+void* formatJobFunc(void* arg){
+    FormatJob* job = (FormatJob*)arg;
+    My402Ledger* ledger = job->ledger;
+
+    long long sum = 0;
+    for(int a = job->start; a < job->end; a++){
+        sum += ledger->amount[a];
+    }
+    job->blockSums[job->index] = sum;
+    pthread_barrier_wait(job->barrier);
+
+    long long balance = job->carry;
+    for(int a = 0; a < job->index; a++){
+        balance += job->blockSums[a];
+    }
+    char* row = job->output;
+    for(int a = job->start; a < job->end; a++){
+        balance += ledger->amount[a];
+        formatRow(row, ledger->timestamp[a], My402LedgerDesc(ledger, a), ledger->amount[a], balance, &job->dateCache);
+        row += ROW_LEN;
+    }
+    return NULL;
+}
+
+/*
+ * The running balance is a prefix sum over the amounts, so the rows are
+ * done a window at a time: each job sums its block of the window, the
+ * blocks are fixed up with the sums in front of them, and every job formats
+ * its rows into a disjoint range of the window buffer, which is then
+ * written in one go.
+ */
+void printTableParallel(My402Ledger* ledger, int numJobs){
+    long long windowRows = (long long)FORMAT_WINDOW_ROWS * numJobs;
+    FormatJob* jobs = (FormatJob*)malloc(sizeof(FormatJob) * numJobs);
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * numJobs);
+    long long* blockSums = (long long*)malloc(sizeof(long long) * numJobs);
+    char* output = (char*)malloc(windowRows * ROW_LEN);
+    if(jobs == NULL || threads == NULL || blockSums == NULL || output == NULL){
+        fprintf(stderr, "Error malloc in printTableParallel.\n");
+        exit(1);
+    }
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, numJobs);
+    for(int a = 0; a < numJobs; a++){
+        My402DateInit(&jobs[a].dateCache);
+    }
+
+    printTableHeader();
+    flushOutput();
+    long long balance = 0;
+    for(long long windowStart = 0; windowStart < ledger->num_rows; windowStart += windowRows){
+        long long windowEnd = min(windowStart + windowRows, ledger->num_rows);
+        long long windowSize = windowEnd - windowStart;
+        for(int a = 0; a < numJobs; a++){
+            jobs[a].ledger = ledger;
+            jobs[a].start = windowStart + windowSize * a / numJobs;
+            jobs[a].end = windowStart + windowSize * (a + 1) / numJobs;
+            jobs[a].index = a;
+            jobs[a].blockSums = blockSums;
+            jobs[a].carry = balance;
+            jobs[a].output = output + (jobs[a].start - windowStart) * ROW_LEN;
+            jobs[a].barrier = &barrier;
+            pthread_create(&threads[a], NULL, formatJobFunc, &jobs[a]);
         }
-        if(!something_swapped){
-            break;
+        for(int a = 0; a < numJobs; a++){
+            pthread_join(threads[a], NULL);
+            balance += blockSums[a];
+        }
+        if(fwrite(output, ROW_LEN, windowSize, stdout) != (size_t)windowSize){
+            fprintf(stderr, "Error writing output.\n");
+            exit(1);
         }
     }
+    printTableFooter();
+
+    pthread_barrier_destroy(&barrier);
+    free(jobs);
+    free(threads);
+    free(blockSums);
+    free(output);
 }
 
-void transferFormat(long long money, char temp[]){
-    memset(temp, 0, 16);
-    temp[0] = ' ';
-    temp[13] = ' ';
-    if(money < 0){
-        temp[0] = '(';
-        temp[13] = ')';
-    }
-    double moneyLimit = 1e9;
-    if(money <= -moneyLimit || money >= moneyLimit){
-        for(int a = 1; a < 13; a++){
-            temp[a] = '?';
-        }
-        temp[10] = '.';
-        temp[2] = ',';
-        temp[6] = ',';
+void printTable(My402Ledger* ledger, int numJobs){
+    if(numJobs > 1 && ledger->num_rows >= FORMAT_WINDOW_ROWS * 2){
+        printTableParallel(ledger, numJobs);
         return;
     }
-    money = abs(money);
-    int index = 12;
-    while(money > 0 && index >= 1){
-        int remainder = money % 10;
-        temp[index] = '0' + remainder;
-        money /= 10;
-        if(index == 11 && money > 0){
-            temp[--index] = '.';
+    printTableHeader();
+    for(int a = 0; a < ledger->num_rows; a++){
+        printTableRow(ledger->timestamp[a], My402LedgerDesc(ledger, a), ledger->amount[a]);
+    }
+    printTableFooter();
+}
+
+void sortLedger(My402Ledger* ledger, int useRadix, int checkDuplicates){
+    if(useRadix){
+        RadixSortLedger(ledger, checkDuplicates);
+    }
+    else{
+        MergeSortLedger(ledger);
+        if(checkDuplicates){
+            checkLedgerDuplicateTime(ledger);
+        }
+    }
+}
+
+int parseChunk(char* data, long long start, long long end, int firstLineNum, My402Ledger* ledger){
+    int lineNum = firstLineNum;
+    long long pos = start;
+    while(pos < end){
+        char* newline = (char*)memchr(data + pos, '\n', end - pos);
+        long long lineEnd = newline != NULL ? newline - data + 1 : end;
+        int lineLen = lineEnd - pos > MAX_LINE_LEN ? MAX_LINE_LEN + 1 : (int)(lineEnd - pos);
+        parseLine(data + pos, lineLen, lineNum, ledger);
+
+        lineNum++;
+        pos = lineEnd;
+    }
+    return lineNum - firstLineNum;
+}
+
+/* counts its lines, waits for the others so it knows its first line number, then parses and sorts */
+void* parseJobFunc(void* arg){
+    ParseJob* job = (ParseJob*)arg;
+    curParseJob = job;
+
+    job->lineCounts[job->index] = countLines(job->data, job->start, job->end);
+    pthread_barrier_wait(job->barrier);
+
+    int firstLineNum = 1;
+    for(int a = 0; a < job->index; a++){
+        firstLineNum += job->lineCounts[a];
+    }
+    parseChunk(job->data, job->start, job->end, firstLineNum, &job->ledger);
+    sortLedger(&job->ledger, job->useRadix, FALSE);
+    return NULL;
+}
+
+/*
+ * -j mode: split the whole input at line boundaries into numJobs chunks,
+ * parse and sort each on its own thread, then k-way merge into ledger.
+ * Returns the number of lines.
+ */
+int parseParallel(My402Input* tfile, int numJobs, int useRadix, My402Ledger* ledger){
+    if(!My402InputReadAll(tfile)){
+        exit(1);
+    }
+    char* data = tfile->data + tfile->pos;
+    long long size = tfile->size - tfile->pos;
+
+    ParseJob* jobs = (ParseJob*)malloc(sizeof(ParseJob) * numJobs);
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * numJobs);
+    int* lineCounts = (int*)malloc(sizeof(int) * numJobs);
+    My402Ledger** ledgers = (My402Ledger**)malloc(sizeof(My402Ledger*) * numJobs);
+    if(jobs == NULL || threads == NULL || lineCounts == NULL || ledgers == NULL){
+        fprintf(stderr, "Error malloc in parseParallel.\n");
+        exit(1);
+    }
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, numJobs);
+
+    long long start = 0;
+    for(int a = 0; a < numJobs; a++){
+        long long end = size * (a + 1) / numJobs;
+        if(end < start){
+            end = start;
         }
-        else if(index == 7 && money > 0){
-            temp[--index] = ',';
+        if(a == numJobs - 1){
+            end = size;
         }
-        else if(index == 3 && money > 0){
-            temp[--index] = ',';
+        else if(end > 0 && end < size){
+            char* newline = (char*)memchr(data + end - 1, '\n', size - end + 1);
+            end = newline != NULL ? newline - data + 1 : size;
         }
-        index--;
+        memset(&jobs[a], 0, sizeof(ParseJob));
+        jobs[a].data = data;
+        jobs[a].start = start;
+        jobs[a].end = end;
+        jobs[a].index = a;
+        jobs[a].useRadix = useRadix;
+        jobs[a].lineCounts = lineCounts;
+        jobs[a].barrier = &barrier;
+        My402LedgerInit(&jobs[a].ledger);
+        ledgers[a] = &jobs[a].ledger;
+        start = end;
     }
-    while(index >= 9){
-        temp[index--] = '0';
+    for(int a = 0; a < numJobs; a++){
+        pthread_create(&threads[a], NULL, parseJobFunc, &jobs[a]);
     }
-    temp[10] = '.';
-    for(int a = index; a >= 1; a--){
-        temp[a] = ' ';
+    for(int a = 0; a < numJobs; a++){
+        pthread_join(threads[a], NULL);
+    }
+    for(int a = 0; a < numJobs; a++){
+        if(jobs[a].errorLine > 0){
+            fprintf(stderr, "%s", jobs[a].errorMsg);
+            exit(1);
+        }
+    }
+
+    int lineNum = 0;
+    for(int a = 0; a < numJobs; a++){
+        lineNum += lineCounts[a];
+    }
+    MergeSortedLedgers(ledger, ledgers, numJobs);
+    for(int a = 0; a < numJobs; a++){
+        My402LedgerFree(&jobs[a].ledger);
+    }
+
+    pthread_barrier_destroy(&barrier);
+    free(jobs);
+    free(threads);
+    free(lineCounts);
+    free(ledgers);
+    return lineNum;
+}
+
+/*
+ * Reads a merge through without printing anything and reports the first
+ * pair of identical timestamps. Equal timestamps come out next to each
+ * other, the two earliest lines first, so that is the pair
+ * checkLedgerDuplicateTime() would report. The caller then rewinds the
+ * sources and starts the merge again to print it, so a duplicate never
+ * leaves half a table on stdout.
+ */
+void checkMergedDuplicates(My402Merge* merge){
+    My402Record record;
+    My402Record prev;
+    int havePrev = FALSE;
+    while(My402MergeNext(merge, &record, NULL)){
+        if(havePrev && record.timestamp == prev.timestamp){
+            fprintf(stderr, "line%d and %d, field: time, there are two identical timestamps.\n", prev.lineNum, record.lineNum);
+            exit(1);
+        }
+        prev = record;
+        havePrev = TRUE;
     }
 }
 
-void PrintTestList(My402List *pList, int num_items){
-    My402ListElem* elem = NULL;
+/* prints the table straight from a merge checkMergedDuplicates() has passed */
+void printMerged(My402Merge* merge){
+    My402Record record;
+    printTableHeader();
+    while(My402MergeNext(merge, &record, NULL)){
+        printTableRow(record.timestamp, record.desc, record.amount);
+    }
+    printTableFooter();
+}
+
+/*
+ * Upper bound on the memory one row of a run needs while it is sorted: 20
+ * bytes of columns, a 25-byte arena slot, two 8-byte sort keys and one
+ * 8-byte slot of the column being gathered.
+ */
+#define RUN_BYTES_PER_ROW (20 + 25 + 16 + 8)
+
+/*
+ * Most runs one merge reads at once, and most runs kept open while the
+ * input is still being parsed, however large -m is.
+ */
+#define MAX_MERGE_FAN_IN 64
+#define MAX_OPEN_RUNS (4 * MAX_MERGE_FAN_IN)
+#define MIN_RUN_BUFFER 4096
+
+/* buffers for count open runs out of the half of memLimit left to merging */
+static size_t runBufferSize(long long memLimit, int count){
+    return (size_t)min(1 << 20, memLimit / 2 / count);
+}
 
-    if (My402ListLength(pList) != num_items) {
-        fprintf(stderr, "List length is not %1d in PrintTestList().\n", num_items);
+static void mergeSetRuns(My402Merge* merge, FILE** runs, int numRuns, size_t bufferSize){
+    if(!My402MergeInit(merge, numRuns)){
+        fprintf(stderr, "Error malloc in sortExternal.\n");
         exit(1);
     }
-    for (elem = My402ListFirst(pList); elem != NULL; elem = My402ListNext(pList, elem)) {
-        My402ListElemObj* curObj = (My402ListElemObj*)(elem->obj);
-        fprintf(stdout, "%s %s %s %s %s %ld %lld\n", curObj->type, curObj->time, curObj->amount, curObj->desc, curObj->timeStr, curObj->timestamp, curObj->amountNum);
+    for(int a = 0; a < numRuns; a++){
+        setvbuf(runs[a], NULL, _IOFBF, bufferSize);
+        My402MergeSetSource(merge, a, runs[a], My402SpillNext);
     }
-    fprintf(stdout, "\n");
+    My402MergeStart(merge);
 }
 
-void printTable(My402List* myList){
-    int bufferSize = 81;
-    char dashLine[bufferSize];
-    char secondLine[bufferSize];
-    memset(dashLine, 0, bufferSize);
-    memset(secondLine, 0, bufferSize);
-    
-    int indexArray[] = {0, 18, 45, 62, 79};
-    for(int a = 0; a < bufferSize - 1; a++){
-        dashLine[a] = '-';
+/*
+ * Merges the last fanIn runs into one longer run in their place. Only
+ * neighbouring runs are merged, so equal timestamps keep their input order.
+ */
+static void mergeLastRuns(FILE** runs, int* levels, int* numRuns, int fanIn, long long memLimit){
+    int first = *numRuns - fanIn;
+    My402Merge merge;
+    mergeSetRuns(&merge, runs + first, fanIn, runBufferSize(memLimit, fanIn + 1));
+    FILE* merged = My402SpillMerge(&merge, runBufferSize(memLimit, fanIn + 1));
+    My402MergeFree(&merge);
+    for(int a = first; a < *numRuns; a++){
+        fclose(runs[a]);
     }
-    for(int a = 0; a < 5; a++){
-        int index = indexArray[a];
-        dashLine[index] = '+';
+    runs[first] = merged;
+    levels[first]++;
+    *numRuns = first + 1;
+}
+
+/*
+ * -m mode: parse the input in runs of at most memLimit bytes, sort each run
+ * and spill it to a temp file, then k-way merge the runs straight into the
+ * table. If everything fits in one run nothing is spilled. At most fanIn runs
+ * are merged at once, with at least MIN_RUN_BUFFER bytes each out of half of
+ * memLimit: whenever fanIn runs of the same level pile up, or MAX_OPEN_RUNS
+ * are open, the newest fanIn are merged into one run of the next level, and
+ * the ones left at the end are merged the same way until fanIn remain.
+ * Those are merged once without printing to find duplicate timestamps that
+ * span runs, then rewound and merged again into the table, so a duplicate
+ * leaves nothing on stdout.
+ */
+void sortExternal(My402Input* tfile, long long memLimit, int useRadix){
+    int rowsPerRun = (int)min(memLimit / RUN_BYTES_PER_ROW, 0x7fffffffLL);
+    if(rowsPerRun < 2){
+        rowsPerRun = 2;
+    }
+    int fanIn = (int)max(2, min(MAX_MERGE_FAN_IN, memLimit / 2 / MIN_RUN_BUFFER - 1));
+    My402Ledger ledger;
+    My402LedgerInit(&ledger);
+    if(!My402LedgerReserve(&ledger, rowsPerRun, (long long)rowsPerRun * 25)){
+        fprintf(stderr, "Error malloc in sortExternal.\n");
+        exit(1);
     }
 
-    for(int a = 0; a < bufferSize - 1; a++){
-        secondLine[a] = ' ';
+    FILE* runs[MAX_OPEN_RUNS];
+    int levels[MAX_OPEN_RUNS];
+    int numRuns = 0;
+    int lineNum = 0;
+    char* inputLine = NULL;
+    int inputLineLen = 0;
+    while(My402InputNextLine(tfile, &inputLine, &inputLineLen)){
+        lineNum++;
+        My402StatsBytes += inputLineLen;
+        parseLine(inputLine, inputLineLen, lineNum, &ledger);
+        if(ledger.num_rows == rowsPerRun){
+            sortLedger(&ledger, useRadix, FALSE);
+            levels[numRuns] = 0;
+            runs[numRuns++] = My402SpillLedger(&ledger);
+            My402LedgerClear(&ledger);
+            if(numRuns >= fanIn && (levels[numRuns - fanIn] == levels[numRuns - 1] || numRuns == MAX_OPEN_RUNS)){
+                /* give the run's memory to the merge buffers meanwhile */
+                My402LedgerFree(&ledger);
+                while(numRuns >= fanIn && (levels[numRuns - fanIn] == levels[numRuns - 1] || numRuns == MAX_OPEN_RUNS)){
+                    mergeLastRuns(runs, levels, &numRuns, fanIn, memLimit);
+                }
+                My402LedgerInit(&ledger);
+                if(!My402LedgerReserve(&ledger, rowsPerRun, (long long)rowsPerRun * 25)){
+                    fprintf(stderr, "Error malloc in sortExternal.\n");
+                    exit(1);
+                }
+            }
+        }
     }
-    for(int a = 0; a < 5; a++){
-        int index = indexArray[a];
-        secondLine[index] = '|';
+    if(lineNum == 0){
+        fprintf(stderr, "there is no transaction.\n");
+        exit(1);
     }
-    
-    char temp1[] = {"Date"};
-    char temp2[] = {"Description"};
-    char temp3[] = {"Amount"};
-    char temp4[] = {"Balance"};
-    for(int a = 8, b = 0; a < 12 && b < strlen(temp1); a++, b++){
-        secondLine[a] = temp1[b];
+    My402StatsLines = lineNum;
+    My402StatsPhaseDone("parse");
+    if(numRuns == 0){
+        sortLedger(&ledger, useRadix, TRUE);
+        My402StatsPhaseDone("sort");
+        printTable(&ledger, 1);
+        My402StatsPhaseDone("print");
+        My402LedgerFree(&ledger);
+        return;
     }
-    for(int a = 20, b = 0; a < 31 && b < strlen(temp2); a++, b++){
-        secondLine[a] = temp2[b];
+    if(ledger.num_rows > 0){
+        sortLedger(&ledger, useRadix, FALSE);
+        levels[numRuns] = 0;
+        runs[numRuns++] = My402SpillLedger(&ledger);
     }
-    for(int a = 55, b = 0; a < 61 && b < strlen(temp3); a++, b++){
-        secondLine[a] = temp3[b];
+    My402LedgerFree(&ledger);
+    while(numRuns > fanIn){
+        mergeLastRuns(runs, levels, &numRuns, fanIn, memLimit);
     }
-    for(int a = 71, b = 0; a < 78 && b < strlen(temp4); a++, b++){
-        secondLine[a] = temp4[b];
+
+    My402Merge merge;
+    mergeSetRuns(&merge, runs, numRuns, runBufferSize(memLimit, numRuns));
+    checkMergedDuplicates(&merge);
+    for(int a = 0; a < numRuns; a++){
+        rewind(runs[a]);
     }
+    My402MergeStart(&merge);
+    My402StatsPhaseDone("sort");
 
-    fprintf(stdout, "%s\n", dashLine);
-    fprintf(stdout, "%s\n", secondLine);
-    fprintf(stdout, "%s\n", dashLine);
+    printMerged(&merge);
+    My402StatsPhaseDone("print");
 
-    long long balance = 0;
-    for (My402ListElem* elem = My402ListFirst(myList); elem != NULL; elem = My402ListNext(myList, elem)) {
-        char line[81];
-        memset(line, 0, 81);
+    My402MergeFree(&merge);
+    for(int a = 0; a < numRuns; a++){
+        fclose(runs[a]);
+    }
+}
 
-        for(int a = 0; a < 80; a++){
-            line[a] = ' ';
-        }
-        for(int a = 0; a < 5; a++){
-            int index = indexArray[a];
-            line[index] = '|';
+void printUsageAndExit(){
+    fprintf(stderr, "useage: ./warmup1 sort [-j N | -m MB] [-a radix|merge] [tfile]\n");
+    fprintf(stderr, "       ./warmup1 merge [-a radix|merge] tfile...\n");
+    fprintf(stderr, "       ./warmup1 compile [-j N] [-a radix|merge] -o ledger [tfile]\n");
+    fprintf(stderr, "       ./warmup1 query [--from date] [--to date] ledger\n");
+    fprintf(stderr, "       ./warmup1 append [-a radix|merge] ledger|tfile [delta]\n");
+    fprintf(stderr, "       --stats can be given to any command to print timings and counters to stderr\n");
+    exit(1);
+}
+
+typedef struct tagMergeInput {
+    FILE *file;
+    My402Input input;
+    int seekable;
+    int sorted;
+    int firstLineNum;
+    int lineNum;
+    My402Ledger ledger;
+    int row;
+} MergeInput;
+
+int mergeInputNextLine(void* source, My402Record* record){
+    MergeInput* mergeInput = (MergeInput*)source;
+    char* line = NULL;
+    int lineLen = 0;
+    if(!My402InputNextLine(&mergeInput->input, &line, &lineLen)){
+        return FALSE;
+    }
+    mergeInput->lineNum++;
+    parseRecord(line, lineLen, mergeInput->lineNum, record);
+    return TRUE;
+}
+
+int mergeInputNextRow(void* source, My402Record* record){
+    MergeInput* mergeInput = (MergeInput*)source;
+    My402Ledger* ledger = &mergeInput->ledger;
+    int row = mergeInput->row;
+    if(row >= ledger->num_rows){
+        return FALSE;
+    }
+    record->timestamp = ledger->timestamp[row];
+    record->amount = ledger->amount[row];
+    record->lineNum = ledger->lineNum[row];
+    strcpy(record->desc, My402LedgerDesc(ledger, row));
+    mergeInput->row++;
+    return TRUE;
+}
+
+/* opens a seekable input again from its first line */
+void reopenMergeInput(MergeInput* mergeInput, char* fileName){
+    if(lseek(fileno(mergeInput->file), 0, SEEK_SET) < 0 || !My402InputOpen(&mergeInput->input, fileno(mergeInput->file))){
+        fprintf(stderr, "Error reading file %s.\n", fileName);
+        exit(1);
+    }
+}
+
+/* puts an input back at its first row once a merge has been through it */
+void rewindMergeInput(MergeInput* mergeInput, char* fileName){
+    mergeInput->lineNum = mergeInput->firstLineNum;
+    mergeInput->row = 0;
+    if(mergeInput->sorted){
+        My402InputClose(&mergeInput->input);
+        reopenMergeInput(mergeInput, fileName);
+    }
+}
+
+/*
+ * warmup1 merge: the result, line numbers in errors included, is what
+ * "cat f1 ... fn | warmup1 sort" would give. A first pass validates every
+ * file in order, so the first bad line overall is the one reported, and
+ * finds out which files are already sorted. Those are then streamed through
+ * the k-way merge a line at a time; the rest (and anything that cannot be
+ * read twice, like a pipe) are sorted in memory first. The merge is run
+ * once without printing to find duplicate timestamps across files, and
+ * only then again to print, as sort finds them all before printing.
+ */
+void mergeFiles(char* files[], int numFiles, int useRadix){
+    MergeInput* inputs = (MergeInput*)calloc(numFiles, sizeof(MergeInput));
+    if(inputs == NULL){
+        fprintf(stderr, "Error malloc in mergeFiles.\n");
+        exit(1);
+    }
+    for(int a = 0; a < numFiles; a++){
+        if((inputs[a].file = fopen(files[a], "r")) == NULL){
+            fprintf(stderr, "Error opening file %s.\n", files[a]);
+            printUsageAndExit();
         }
+    }
 
-        char amountStr[16];
-        char balanceStr[16];
+    int lineNum = 0;
+    for(int a = 0; a < numFiles; a++){
+        MergeInput* mergeInput = &inputs[a];
+        int fd = fileno(mergeInput->file);
+        mergeInput->seekable = lseek(fd, 0, SEEK_CUR) >= 0;
+        mergeInput->sorted = mergeInput->seekable;
+        mergeInput->lineNum = lineNum;
+        My402LedgerInit(&mergeInput->ledger);
+        if(!My402InputOpen(&mergeInput->input, fd)){
+            exit(1);
+        }
 
-        My402ListElemObj* curObj = (My402ListElemObj*)(elem->obj);
-        transferFormat(curObj->amountNum, amountStr);
-        balance += curObj->amountNum;
-        transferFormat(balance, balanceStr);
+        unsigned int prevTime = 0;
+        char* line = NULL;
+        int lineLen = 0;
+        while(My402InputNextLine(&mergeInput->input, &line, &lineLen)){
+            lineNum++;
+            My402StatsBytes += lineLen;
+            if(!mergeInput->seekable){
+                parseLine(line, lineLen, lineNum, &mergeInput->ledger);
+                continue;
+            }
+            My402Record record;
+            parseRecord(line, lineLen, lineNum, &record);
+            if(record.timestamp < prevTime){
+                mergeInput->sorted = FALSE;
+            }
+            prevTime = record.timestamp;
+        }
+        My402InputClose(&mergeInput->input);
+    }
+    if(lineNum == 0){
+        fprintf(stderr, "there is no transaction.\n");
+        exit(1);
+    }
+    My402StatsLines = lineNum;
+    My402StatsPhaseDone("parse");
 
-        for(int a = 2, b = 0; a < indexArray[1] - 1 && b < strlen(curObj->timeStr); a++, b++){
-            line[a] = curObj->timeStr[b];
+    My402Merge merge;
+    if(!My402MergeInit(&merge, numFiles)){
+        fprintf(stderr, "Error malloc in mergeFiles.\n");
+        exit(1);
+    }
+    for(int a = 0; a < numFiles; a++){
+        MergeInput* mergeInput = &inputs[a];
+        mergeInput->firstLineNum = mergeInput->lineNum;
+        if(mergeInput->seekable){
+            reopenMergeInput(mergeInput, files[a]);
         }
-        for(int a = 20, b = 0; a < indexArray[2] - 1 && b < strlen(curObj->desc); a++, b++){
-            line[a] = curObj->desc[b];
+        if(mergeInput->sorted){
+            My402MergeSetSource(&merge, a, mergeInput, mergeInputNextLine);
+            continue;
         }
-        for(int a = 47, b = 0; a < indexArray[3] - 1 && b < strlen(amountStr); a++, b++){
-            line[a] = amountStr[b];
+        if(mergeInput->seekable){
+            char* line = NULL;
+            int lineLen = 0;
+            while(My402InputNextLine(&mergeInput->input, &line, &lineLen)){
+                mergeInput->lineNum++;
+                parseLine(line, lineLen, mergeInput->lineNum, &mergeInput->ledger);
+            }
+            My402InputClose(&mergeInput->input);
         }
-        for(int a = 64, b = 0; a < indexArray[4] - 1 && b < strlen(balanceStr); a++, b++){
-            line[a] = balanceStr[b];
+        sortLedger(&mergeInput->ledger, useRadix, FALSE);
+        My402MergeSetSource(&merge, a, mergeInput, mergeInputNextRow);
+    }
+    My402MergeStart(&merge);
+    checkMergedDuplicates(&merge);
+    for(int a = 0; a < numFiles; a++){
+        rewindMergeInput(&inputs[a], files[a]);
+    }
+    My402MergeStart(&merge);
+    My402StatsPhaseDone("sort");
+    printMerged(&merge);
+    My402StatsPhaseDone("print");
+
+    My402MergeFree(&merge);
+    for(int a = 0; a < numFiles; a++){
+        if(inputs[a].sorted){
+            My402InputClose(&inputs[a].input);
         }
-        fprintf(stdout, "%s\n", line);
+        My402LedgerFree(&inputs[a].ledger);
+        fclose(inputs[a].file);
     }
-    fprintf(stdout, "%s\n", dashLine);
+    free(inputs);
 }
 
-int main(int argc, char *argv[]){
-    FILE* input;
-    if(argc == 1){
-        fprintf(stderr, "malformed command\n");
-        fprintf(stderr, "useage: ./warmup1 sort [tfile]\n");
+/* a Unix timestamp, or a local date as YYYY-MM-DD; a date used as --to means the end of that day */
+int parseQueryTime(const char* value, int endOfDay, unsigned int* timestamp){
+    char* end = NULL;
+    if(*value >= '0' && *value <= '9'){
+        unsigned long long number = strtoull(value, &end, 10);
+        if(*end == '\0'){
+            if(number > 0xffffffffULL){
+                return FALSE;
+            }
+            *timestamp = (unsigned int)number;
+            return TRUE;
+        }
+    }
+    int year = 0, month = 0, day = 0;
+    char extra = 0;
+    if(sscanf(value, "%4d-%2d-%2d%c", &year, &month, &day, &extra) != 3 || month < 1 || month > 12 || day < 1 || day > 31){
+        return FALSE;
+    }
+    struct tm timeInfo;
+    memset(&timeInfo, 0, sizeof(timeInfo));
+    timeInfo.tm_year = year - 1900;
+    timeInfo.tm_mon = month - 1;
+    timeInfo.tm_mday = day + (endOfDay ? 1 : 0);
+    timeInfo.tm_isdst = -1;
+    time_t result = mktime(&timeInfo);
+    if(endOfDay){
+        result--;
+    }
+    if(result < 0){
+        result = 0;
+    }
+    *timestamp = result > 0xffffffffLL ? 0xffffffffU : (unsigned int)result;
+    return TRUE;
+}
+
+/* warmup1 query: prints the rows of a compiled ledger in [from, to] with their stored balances */
+void queryLedger(const char* path, unsigned int from, unsigned int to){
+    My402LedgerFile ledgerFile;
+    if(!My402LedgerFileOpen(&ledgerFile, path)){
         exit(1);
     }
-    else if(argc == 2){
-        if(strcmp("sort", argv[1]) != 0){
-            fprintf(stderr, "malformed command, %s is not a valid commandline option\n", argv[1]);
-            fprintf(stderr, "useage: ./warmup1 sort [tfile]\n");
-            exit(1);
+    long long first = My402LedgerFileLowerBound(&ledgerFile, from);
+    long long last = to == 0xffffffffU ? ledgerFile.num_rows : My402LedgerFileLowerBound(&ledgerFile, to + 1);
+
+    printTableHeader();
+    if(first < last){
+        const My402LedgerRow* row = &ledgerFile.rows[first];
+        tableBalance = row->balance - row->amount;
+    }
+    for(long long a = first; a < last; a++){
+        const My402LedgerRow* row = &ledgerFile.rows[a];
+        printTableRow(row->timestamp, row->desc, row->amount);
+    }
+    printTableFooter();
+    My402LedgerFileClose(&ledgerFile);
+    My402StatsPhaseDone("print");
+}
+
+/* timestamp field of a history line, without the checks parseRecord() does */
+unsigned int lineTime(const char* line, long long len){
+    long long pos = 0;
+    while(pos < len && line[pos] != '\t'){
+        pos++;
+    }
+    unsigned long long value = 0;
+    for(pos++; pos < len && line[pos] >= '0' && line[pos] <= '9'; pos++){
+        value = value * 10 + (line[pos] - '0');
+    }
+    return value > 0xffffffffULL ? 0xffffffffU : (unsigned int)value;
+}
+
+long long lineEnd(const char* data, long long pos, long long size){
+    const char* newline = (const char*)memchr(data + pos, '\n', size - pos);
+    return newline != NULL ? newline - data + 1 : size;
+}
+
+/* offset of the first line of the sorted tfile data whose timestamp is >= timestamp */
+long long textLowerBound(const char* data, long long size, unsigned int timestamp){
+    long long low = 0;
+    long long high = size;
+    while(low < high){
+        long long start = low + (high - low) / 2;
+        while(start > low && data[start - 1] != '\n'){
+            start--;
+        }
+        long long end = lineEnd(data, start, size);
+        if(lineTime(data + start, end - start) < timestamp){
+            low = end;
+        }
+        else{
+            high = start;
         }
-        input = stdin;
     }
-    else if(argc == 3){
-        if(strcmp("sort", argv[1]) != 0){
-            fprintf(stderr, "malformed command, %s is not a valid commandline option\n", argv[1]);
-            fprintf(stderr, "useage: ./warmup1 sort [tfile]\n");
+    return low;
+}
+
+/*
+ * Copies the first size bytes of the file at fromFd to the empty file at
+ * toFd and leaves toFd's offset after them. Where the filesystem can it
+ * shares the blocks instead (a reflink), and otherwise the kernel copies
+ * them; nothing passes through user memory either way.
+ */
+int copyFilePrefix(int fromFd, int toFd, long long size){
+    if(size == 0){
+        return TRUE;
+    }
+    if(ioctl(toFd, FICLONE, fromFd) == 0){
+        return ftruncate(toFd, size) == 0 && lseek(toFd, size, SEEK_SET) == size;
+    }
+    off_t offset = 0;
+    while(offset < size){
+        if(sendfile(toFd, fromFd, &offset, (size_t)min(size - offset, 1LL << 30)) <= 0){
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Appends a sorted delta to a sorted tfile. Only the lines from the first
+ * one not older than the delta are read (and validated) and merged with the
+ * delta; the lines in front of them are found by binary search and not
+ * read, only cloned or copied by copyFilePrefix(). The result goes to
+ * path.tmp, which is synced and renamed over path, so a crash never leaves a
+ * half-merged tfile. Delta lines are
+ * numbered as if they followed the history, so errors read like "cat
+ * history delta | warmup1 sort"; history lines are only counted when there
+ * is an error to report.
+ */
+void appendText(const char* path, My402Ledger* delta, char* deltaData, long long* deltaLineStart){
+    int fd = open(path, O_RDONLY);
+    struct stat fileStat;
+    if(fd < 0 || fstat(fd, &fileStat) != 0){
+        fprintf(stderr, "Error opening file %s.\n", path);
+        exit(1);
+    }
+    long long size = fileStat.st_size;
+    char* data = size > 0 ? (char*)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0) : NULL;
+    if(data == MAP_FAILED){
+        fprintf(stderr, "Error reading file %s.\n", path);
+        exit(1);
+    }
+    long long first = textLowerBound(data, size, delta->timestamp[0]);
+
+    long long mergedCapacity = size - first + deltaLineStart[delta->num_rows] + delta->num_rows + 1;
+    char* merged = (char*)malloc(mergedCapacity);
+    if(merged == NULL){
+        fprintf(stderr, "Error malloc in appendText.\n");
+        exit(1);
+    }
+    long long mergedLen = 0;
+    long long pos = first;
+    int historyLine = 0;
+    int deltaRow = 0;
+    unsigned int prevTime = 0;
+    int prevLine = 0;
+    lineNumPrefix = data;
+    lineNumPrefixLen = first;
+    while(pos < size || deltaRow < delta->num_rows){
+        My402Record record;
+        long long end = pos < size ? lineEnd(data, pos, size) : size;
+        if(pos < size){
+            int lineLen = end - pos > MAX_LINE_LEN ? MAX_LINE_LEN + 1 : (int)(end - pos);
+            parseRecord(data + pos, lineLen, historyLine + 1, &record);
+        }
+        int fromHistory = pos < size && (deltaRow >= delta->num_rows || record.timestamp <= delta->timestamp[deltaRow]);
+        int curLine = fromHistory ? -(historyLine + 1) : delta->lineNum[deltaRow];
+        unsigned int timestamp = fromHistory ? record.timestamp : delta->timestamp[deltaRow];
+        if(mergedLen > 0 && timestamp <= prevTime){
+            /* history lines are negative, delta lines are relative to the end of the history */
+            int historyBase = countLines(data, 0, first);
+            int deltaBase = countLines(data, 0, size);
+            int line1 = prevLine < 0 ? historyBase - prevLine : deltaBase + prevLine;
+            int line2 = curLine < 0 ? historyBase - curLine : deltaBase + curLine;
+            if(timestamp < prevTime){
+                fprintf(stderr, "line%d, field: time, %s is not sorted.\n", line2, path);
+            }
+            else{
+                fprintf(stderr, "line%d and %d, field: time, there are two identical timestamps.\n", line1, line2);
+            }
             exit(1);
         }
-        if((input = fopen(argv[2], "r")) == NULL){
-            fprintf(stderr, "Error opening file %s.\n", argv[2]);
-            fprintf(stderr, "useage: ./warmup1 sort [tfile]\n");
+        const char* line = NULL;
+        long long lineLen = 0;
+        if(fromHistory){
+            line = data + pos;
+            lineLen = end - pos;
+            pos = end;
+            historyLine++;
+        }
+        else{
+            int deltaLine = delta->lineNum[deltaRow++];
+            line = deltaData + deltaLineStart[deltaLine - 1];
+            lineLen = deltaLineStart[deltaLine] - deltaLineStart[deltaLine - 1];
+        }
+        memcpy(merged + mergedLen, line, lineLen);
+        mergedLen += lineLen;
+        if(merged[mergedLen - 1] != '\n'){
+            merged[mergedLen++] = '\n';
+        }
+        prevTime = timestamp;
+        prevLine = curLine;
+    }
+    lineNumPrefix = NULL;
+
+    char tempPath[MAXPATHLENGTH + 8];
+    if(snprintf(tempPath, sizeof(tempPath), "%s.tmp", path) >= (int)sizeof(tempPath)){
+        fprintf(stderr, "File name %s is too long.\n", path);
+        exit(1);
+    }
+    int tempFd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE* file = tempFd >= 0 ? fdopen(tempFd, "w") : NULL;
+    if(file == NULL){
+        fprintf(stderr, "Error opening file %s.\n", tempPath);
+        exit(1);
+    }
+    int ok = fchmod(tempFd, fileStat.st_mode & 07777) == 0 &&
+             copyFilePrefix(fd, tempFd, first) &&
+             (mergedLen == 0 || fwrite(merged, mergedLen, 1, file) == 1) &&
+             fflush(file) == 0 && fsync(tempFd) == 0;
+    close(fd);
+    if(fclose(file) != 0 || !ok || rename(tempPath, path) != 0){
+        fprintf(stderr, "Error writing file %s.\n", path);
+        unlink(tempPath);
+        exit(1);
+    }
+    if(data != NULL){
+        munmap(data, size);
+    }
+    free(merged);
+}
+
+/*
+ * warmup1 append: merges a delta tfile into a compiled ledger or a sorted
+ * tfile. Only the delta is sorted, and only history rows from the oldest
+ * delta timestamp on are parsed and merged; the older ones are copied
+ * unchanged into the replacement file.
+ */
+void appendFiles(const char* path, FILE* input, int useRadix){
+    int isBinary = My402LedgerFileCheck(path);
+    int firstLineNum = 0;
+    if(isBinary){
+        My402LedgerFile ledgerFile;
+        if(!My402LedgerFileOpen(&ledgerFile, path)){
             exit(1);
         }
+        firstLineNum = ledgerFile.num_rows;
+        My402LedgerFileClose(&ledgerFile);
     }
     else{
-        fprintf(stderr, "malformed command\n");
-        fprintf(stderr, "useage: ./warmup1 sort [tfile]\n");
+        int fd = open(path, O_RDONLY);
+        struct stat fileStat;
+        if(fd < 0 || fstat(fd, &fileStat) != 0){
+            fprintf(stderr, "Error opening file %s.\n", path);
+            printUsageAndExit();
+        }
+        if(fileStat.st_size > 0){
+            lineNumPrefix = (char*)mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            lineNumPrefixLen = fileStat.st_size;
+            if(lineNumPrefix == MAP_FAILED){
+                fprintf(stderr, "Error reading file %s.\n", path);
+                exit(1);
+            }
+        }
+        close(fd);
+    }
+
+    My402Input tfile;
+    if(!My402InputOpen(&tfile, fileno(input)) || !My402InputReadAll(&tfile)){
         exit(1);
     }
+    My402Ledger delta;
+    My402LedgerInit(&delta);
+    long long* lineStart = NULL;
+    long long lineCapacity = 0;
+    int lineNum = 0;
+    char* line = NULL;
+    int lineLen = 0;
+    while(My402InputNextLine(&tfile, &line, &lineLen)){
+        if(lineNum + 2 > lineCapacity){
+            lineCapacity = max(lineCapacity * 2, 1024);
+            lineStart = (long long*)realloc(lineStart, sizeof(long long) * lineCapacity);
+            if(lineStart == NULL){
+                fprintf(stderr, "Error malloc in appendFiles.\n");
+                exit(1);
+            }
+        }
+        lineStart[lineNum] = line - tfile.data;
+        lineNum++;
+        lineStart[lineNum] = line + lineLen - tfile.data;
+        parseLine(line, lineLen, isBinary ? firstLineNum + lineNum : lineNum, &delta);
+    }
+    My402StatsLines = lineNum;
+    My402StatsBytes = lineNum > 0 ? lineStart[lineNum] : 0;
+    My402StatsPhaseDone("parse");
+    if(lineNumPrefix != NULL){
+        munmap(lineNumPrefix, lineNumPrefixLen);
+        lineNumPrefix = NULL;
+    }
+    if(lineNum > 0){
+        sortLedger(&delta, useRadix, FALSE);
+        My402StatsPhaseDone("sort");
+        if(isBinary){
+            if(!My402LedgerFileAppend(path, &delta)){
+                exit(1);
+            }
+        }
+        else{
+            appendText(path, &delta, tfile.data, lineStart);
+        }
+        My402StatsPhaseDone("merge");
+    }
+    free(lineStart);
+    My402LedgerFree(&delta);
+    My402InputClose(&tfile);
+}
 
-    int bufferSize = 1050;
-    char inputLine[bufferSize];
-    char type[bufferSize];
-    char time[bufferSize];
-    char amout[bufferSize];
-    char desc[bufferSize];
+#define COMMAND_SORT 0
+#define COMMAND_MERGE 1
+#define COMMAND_COMPILE 2
+#define COMMAND_QUERY 3
+#define COMMAND_APPEND 4
 
-    My402List myList;
-    memset(&myList, 0, sizeof(myList));
-    My402ListInit(&myList);
+int main(int argc, char *argv[]){
+    FILE* input = stdin;
+    int numJobs = 1;
+    int useRadix = TRUE;
+    long long memLimit = 0;
+    char* outputPath = NULL;
+    unsigned int queryFrom = 0;
+    unsigned int queryTo = 0xffffffffU;
+    if(argc == 1){
+        fprintf(stderr, "malformed command\n");
+        printUsageAndExit();
+    }
+    int command = COMMAND_SORT;
+    if(strcmp("merge", argv[1]) == 0){
+        command = COMMAND_MERGE;
+    }
+    else if(strcmp("compile", argv[1]) == 0){
+        command = COMMAND_COMPILE;
+    }
+    else if(strcmp("query", argv[1]) == 0){
+        command = COMMAND_QUERY;
+    }
+    else if(strcmp("append", argv[1]) == 0){
+        command = COMMAND_APPEND;
+    }
+    else if(strcmp("sort", argv[1]) != 0){
+        fprintf(stderr, "malformed command, %s is not a valid commandline option\n", argv[1]);
+        printUsageAndExit();
+    }
+    int argIndex = 2;
+    while(argIndex < argc && argv[argIndex][0] == '-'){
+        char* option = argv[argIndex];
+        if(strcmp("--stats", option) == 0){
+            My402StatsEnabled = TRUE;
+            argIndex++;
+            continue;
+        }
+        if(argIndex + 1 >= argc){
+            fprintf(stderr, "malformed command, value for %s is not given\n", option);
+            printUsageAndExit();
+        }
+        char* value = argv[argIndex + 1];
+        if(strcmp("-j", option) == 0 && (command == COMMAND_SORT || command == COMMAND_COMPILE)){
+            char* end = NULL;
+            long jobs = strtol(value, &end, 10);
+            if(*value == '\0' || *end != '\0' || jobs < 1 || jobs > 1024){
+                fprintf(stderr, "malformed command, -j value %s is not in valid range [1, 1024]\n", value);
+                printUsageAndExit();
+            }
+            numJobs = (int)jobs;
+        }
+        else if(strcmp("-m", option) == 0 && command == COMMAND_SORT){
+            char* end = NULL;
+            long megabytes = strtol(value, &end, 10);
+            if(*value == '\0' || *end != '\0' || megabytes < 1 || megabytes > 1048576){
+                fprintf(stderr, "malformed command, -m value %s is not in valid range [1, 1048576]\n", value);
+                printUsageAndExit();
+            }
+            memLimit = (long long)megabytes << 20;
+        }
+        else if(strcmp("-a", option) == 0 && command != COMMAND_QUERY){
+            if(strcmp("radix", value) == 0){
+                useRadix = TRUE;
+            }
+            else if(strcmp("merge", value) == 0){
+                useRadix = FALSE;
+            }
+            else{
+                fprintf(stderr, "malformed command, -a value %s is not radix or merge\n", value);
+                printUsageAndExit();
+            }
+        }
+        else if(strcmp("-o", option) == 0 && command == COMMAND_COMPILE){
+            outputPath = value;
+        }
+        else if((strcmp("--from", option) == 0 || strcmp("--to", option) == 0) && command == COMMAND_QUERY){
+            int isTo = strcmp("--to", option) == 0;
+            if(!parseQueryTime(value, isTo, isTo ? &queryTo : &queryFrom)){
+                fprintf(stderr, "malformed command, %s value %s is not a timestamp or YYYY-MM-DD\n", option, value);
+                printUsageAndExit();
+            }
+        }
+        else{
+            fprintf(stderr, "malformed command, %s is not a valid commandline option\n", option);
+            printUsageAndExit();
+        }
+        argIndex += 2;
+    }
+    if(numJobs > 1 && memLimit > 0){
+        fprintf(stderr, "malformed command, -j and -m cannot be used together\n");
+        printUsageAndExit();
+    }
+    curTime = time(NULL);
+    tzset();
+    My402ScanInit(NULL);
+    My402StatsStart(argv[1]);
+    if(command == COMMAND_MERGE){
+        if(argIndex >= argc){
+            fprintf(stderr, "malformed command, no tfile to merge\n");
+            printUsageAndExit();
+        }
+        mergeFiles(&argv[argIndex], argc - argIndex, useRadix);
+        My402StatsPrint();
+        return 0;
+    }
+    if(command == COMMAND_QUERY){
+        if(argc - argIndex != 1){
+            fprintf(stderr, "malformed command, query takes exactly one ledger file\n");
+            printUsageAndExit();
+        }
+        queryLedger(argv[argIndex], queryFrom, queryTo);
+        My402StatsPrint();
+        return 0;
+    }
+    if(command == COMMAND_APPEND){
+        if(argc - argIndex < 1 || argc - argIndex > 2){
+            fprintf(stderr, "malformed command, append takes a ledger or tfile and at most one delta\n");
+            printUsageAndExit();
+        }
+        if(argIndex + 1 < argc && (input = fopen(argv[argIndex + 1], "r")) == NULL){
+            fprintf(stderr, "Error opening file %s.\n", argv[argIndex + 1]);
+            printUsageAndExit();
+        }
+        appendFiles(argv[argIndex], input, useRadix);
+        fclose(input);
+        My402StatsPrint();
+        return 0;
+    }
+    if(command == COMMAND_COMPILE && outputPath == NULL){
+        fprintf(stderr, "malformed command, -o ledger is not given\n");
+        printUsageAndExit();
+    }
+    if(argIndex < argc){
+        if((input = fopen(argv[argIndex], "r")) == NULL){
+            fprintf(stderr, "Error opening file %s.\n", argv[argIndex]);
+            printUsageAndExit();
+        }
+        argIndex++;
+    }
+    if(argIndex < argc){
+        fprintf(stderr, "malformed command\n");
+        printUsageAndExit();
+    }
 
-    int lineNum = 0;
-    while(!feof(input) && fgets(inputLine, bufferSize, input) != NULL){
-        memset(type, 0, bufferSize);
-        memset(time, 0, bufferSize);
-        memset(amout, 0, bufferSize);
-        memset(desc, 0, bufferSize);
+    My402Input tfile;
+    if(memLimit > 0 ? !My402InputOpenStream(&tfile, fileno(input)) : !My402InputOpen(&tfile, fileno(input))){
+        exit(1);
+    }
 
-        sscanf(inputLine, "%s %s %s %[^\n]", type, time, amout, desc);
+    if(memLimit > 0){
+        sortExternal(&tfile, memLimit, useRadix);
+        My402InputClose(&tfile);
+        fclose(input);
+        My402StatsPrint();
+        return 0;
+    }
 
-        lineNum++;
-        checkLine(inputLine, strlen(inputLine), lineNum);
-        checkType(type, strlen(type), lineNum);
-        long inputTime = checkTime(time, strlen(time), lineNum);
-        long long myAmount = checkAmount(amout, strlen(amout), lineNum);
-        checkDesc(desc, strlen(desc), lineNum);
+    My402Ledger ledger;
+    My402LedgerInit(&ledger);
 
-        My402ListElemObj* obj = (My402ListElemObj*)malloc(sizeof(My402ListElemObj));
-        strcpy(obj->type, type);
-        strcpy(obj->time, time);
-        strcpy(obj->amount, amout);
-        strcpy(obj->desc, desc);
-        
-        struct tm* timeInfo = localtime(&inputTime);
-        strftime(obj->timeStr, 16, "%a %b %d %Y", timeInfo);
-        if(obj->timeStr[8] == '0'){
-            obj->timeStr[8] = ' ';
-        }
-        obj->timestamp = inputTime;
-        obj->amountNum = myAmount;
-        if(type[0] == '-'){
-            obj->amountNum *= -1;
+    int lineNum = 0;
+    if(numJobs > 1){
+        lineNum = parseParallel(&tfile, numJobs, useRadix, &ledger);
+        My402StatsBytes = tfile.size;
+    }
+    else{
+        char* inputLine = NULL;
+        int inputLineLen = 0;
+        while(My402InputNextLine(&tfile, &inputLine, &inputLineLen)){
+            lineNum++;
+            My402StatsBytes += inputLineLen;
+            parseLine(inputLine, inputLineLen, lineNum, &ledger);
         }
-        obj->lineNum = lineNum;
-
-        My402ListAppend(&myList, obj);
     }
+    My402StatsLines = lineNum;
 
     if(lineNum == 0){
         fprintf(stderr, "there is no transaction.\n");
         exit(1);
     }
+    My402StatsPhaseDone("parse");
 
-    BubbleSortForwardList(&myList, myList.num_members);
-    
-    printTable(&myList);
+    if(numJobs > 1){
+        checkLedgerDuplicateTime(&ledger);
+    }
+    else{
+        sortLedger(&ledger, useRadix, TRUE);
+    }
+    My402StatsPhaseDone("sort");
+
+    if(command == COMMAND_COMPILE){
+        if(!My402LedgerWriteFile(&ledger, outputPath)){
+            exit(1);
+        }
+        My402StatsPhaseDone("write");
+    }
+    else{
+        printTable(&ledger, numJobs);
+        My402StatsPhaseDone("print");
+    }
 
-    My402ListUnlinkAll(&myList);
+    My402LedgerFree(&ledger);
+    My402InputClose(&tfile);
     fclose(input);
+    My402StatsPrint();
 
     return 0;
-}
\ No newline at end of file
+}
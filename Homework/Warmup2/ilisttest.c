@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "my402ilist.h"
+
+#define MAX_ITEMS 256
+
+int gnOps = 100000;
+int gnSeed = 1;
+
+typedef struct tagTestItem {
+    int id;
+    My402IListLink link;
+} TestItem;
+
+/* what one list should hold, in order */
+typedef struct tagTestModel {
+    int num_items;
+    int ids[MAX_ITEMS];
+} TestModel;
+
+TestItem gItems[MAX_ITEMS];
+My402IList gLists[2];
+TestModel gModels[2];
+
+void Usage(){
+    fprintf(stderr, "usage: ilisttest [-ops=positive_integer] [-seed=positive_integer]\n");
+    exit(1);
+}
+
+void ProcessOptions(int argc, char *argv[]){
+    for(int a = 1; a < argc; a++){
+        if(strncmp(argv[a], "-ops=", 5) == 0){
+            if(sscanf(&argv[a][5], "%d", &gnOps) != 1 || gnOps <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-seed=", 6) == 0){
+            if(sscanf(&argv[a][6], "%d", &gnSeed) != 1 || gnSeed <= 0){
+                Usage();
+            }
+        }
+        else{
+            Usage();
+        }
+    }
+}
+
+int randomBelow(int n){
+    return (int)(drand48() * n) % n;
+}
+
+My402IListLink* nthLink(My402IList* list, int n){
+    My402IListLink* link = My402IListFirst(list);
+    while(link != NULL && n > 0){
+        link = My402IListNext(list, link);
+        n--;
+    }
+    return link;
+}
+
+/* Length, both walk directions and IsLinked must all agree with the models */
+void checkLists(const char* where, int op){
+    int linked = 0;
+    for(int l = 0; l < 2; l++){
+        My402IList* list = &gLists[l];
+        TestModel* model = &gModels[l];
+        if(My402IListLength(list) != model->num_items || My402IListEmpty(list) != (model->num_items == 0)){
+            fprintf(stderr, "op %d: list %d length is %d, not %d after %s.\n", op, l, My402IListLength(list), model->num_items, where);
+            exit(1);
+        }
+        int a = 0;
+        for(My402IListLink* link = My402IListFirst(list); link != NULL; link = My402IListNext(list, link), a++){
+            if(a >= model->num_items || My402IListItem(link, TestItem, link)->id != model->ids[a]){
+                fprintf(stderr, "op %d: list %d item %d is wrong walking forward after %s.\n", op, l, a, where);
+                exit(1);
+            }
+        }
+        if(a != model->num_items){
+            fprintf(stderr, "op %d: list %d forward walk ends at %d after %s.\n", op, l, a, where);
+            exit(1);
+        }
+        a = model->num_items - 1;
+        for(My402IListLink* link = My402IListLast(list); link != NULL; link = My402IListPrev(list, link), a--){
+            if(a < 0 || My402IListItem(link, TestItem, link)->id != model->ids[a]){
+                fprintf(stderr, "op %d: list %d item %d is wrong walking backward after %s.\n", op, l, a, where);
+                exit(1);
+            }
+        }
+        if(a != -1){
+            fprintf(stderr, "op %d: list %d backward walk ends at %d after %s.\n", op, l, a, where);
+            exit(1);
+        }
+        linked += model->num_items;
+    }
+    for(int a = 0; a < MAX_ITEMS; a++){
+        linked -= My402IListIsLinked(&gItems[a].link);
+    }
+    if(linked != 0){
+        fprintf(stderr, "op %d: the lists and IsLinked disagree after %s.\n", op, where);
+        exit(1);
+    }
+}
+
+/* moves count ids of src from start to right after afterId in dst, or to its end if afterId < 0 */
+void modelMove(TestModel* dst, int afterId, TestModel* src, int start, int count){
+    int run[MAX_ITEMS];
+    memcpy(run, &src->ids[start], sizeof(int) * count);
+    memmove(&src->ids[start], &src->ids[start + count], sizeof(int) * (src->num_items - start - count));
+    src->num_items -= count;
+
+    int pos = dst->num_items;
+    for(int a = 0; afterId >= 0 && a < dst->num_items; a++){
+        if(dst->ids[a] == afterId){
+            pos = a + 1;
+            break;
+        }
+    }
+    memmove(&dst->ids[pos + count], &dst->ids[pos], sizeof(int) * (dst->num_items - pos));
+    memcpy(&dst->ids[pos], run, sizeof(int) * count);
+    dst->num_items += count;
+}
+
+/* links a random unlinked item at the end of list to */
+void randomAppend(int to){
+    int id = randomBelow(MAX_ITEMS);
+    if(My402IListIsLinked(&gItems[id].link)){
+        return;
+    }
+    My402IListAppend(&gLists[to], &gItems[id].link);
+    gModels[to].ids[gModels[to].num_items++] = id;
+}
+
+/* a random run moved within one list or to the other one */
+void randomSplice(int from, int to){
+    TestModel* src = &gModels[from];
+    TestModel* dst = &gModels[to];
+    int start = randomBelow(src->num_items);
+    int count = randomBelow(src->num_items - start) + 1;
+    My402IListLink* first = nthLink(&gLists[from], start);
+    My402IListLink* last = nthLink(&gLists[from], start + count - 1);
+    My402IListLink* after = NULL;
+    if(from == to){
+        /* the insertion point must be outside the run */
+        int outside = src->num_items - count;
+        int pos = randomBelow(outside + 1);
+        if(pos < outside){
+            after = nthLink(&gLists[from], pos < start ? pos : pos + count);
+        }
+    }
+    else{
+        int pos = randomBelow(dst->num_items + 1);
+        if(pos < dst->num_items){
+            after = nthLink(&gLists[to], pos);
+        }
+    }
+    int afterId = after != NULL ? My402IListItem(after, TestItem, link)->id : -1;
+    My402IListSplice(&gLists[to], after, &gLists[from], first, last, count);
+    modelMove(dst, afterId, src, start, count);
+}
+
+int main(int argc, char *argv[]){
+    ProcessOptions(argc, argv);
+    srand48(gnSeed);
+
+    for(int a = 0; a < MAX_ITEMS; a++){
+        gItems[a].id = a;
+        My402IListLinkInit(&gItems[a].link);
+    }
+    My402IListInit(&gLists[0]);
+    My402IListInit(&gLists[1]);
+    memset(gModels, 0, sizeof(gModels));
+
+    int appends = 0, splices = 0, splits = 0, concats = 0;
+    for(int op = 0; op < gnOps; op++){
+        int from = randomBelow(2);
+        int to = randomBelow(2);
+        int kind = gModels[from].num_items == 0 ? 0 : randomBelow(6);
+        const char* where = "Append";
+        if(kind <= 2){
+            randomAppend(to);
+            appends++;
+        }
+        else if(kind == 3){
+            randomSplice(from, to);
+            splices++;
+            where = "Splice";
+        }
+        else if(kind == 4){
+            /* SplitAt into the other list, with the count given or counted */
+            int start = randomBelow(gModels[from].num_items);
+            int count = gModels[from].num_items - start;
+            My402IListSplitAt(&gLists[from], nthLink(&gLists[from], start), &gLists[1 - from], randomBelow(2) ? count : -1);
+            modelMove(&gModels[1 - from], -1, &gModels[from], start, count);
+            splits++;
+            where = "SplitAt";
+        }
+        else{
+            My402IListConcat(&gLists[1 - from], &gLists[from]);
+            modelMove(&gModels[1 - from], -1, &gModels[from], 0, gModels[from].num_items);
+            concats++;
+            where = "Concat";
+        }
+        checkLists(where, op);
+    }
+
+    fprintf(stdout, "%d ops: %d appends, %d splices, %d splits, %d concats, all consistent\n", gnOps, appends, splices, splits, concats);
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "my402ilist.h"
+
+static void linkBetween(My402IListLink* link, My402IListLink* prev, My402IListLink* next){
+    link->prev = prev;
+    link->next = next;
+    prev->next = link;
+    next->prev = link;
+}
+
+int My402IListLength(My402IList* my402IList){
+    return my402IList->num_members;
+}
+
+int My402IListEmpty(My402IList* my402IList){
+    return my402IList->num_members == 0;
+}
+
+void My402IListAppend(My402IList* my402IList, My402IListLink* link){
+    linkBetween(link, my402IList->anchor.prev, &my402IList->anchor);
+    my402IList->num_members++;
+}
+
+void My402IListPrepend(My402IList* my402IList, My402IListLink* link){
+    linkBetween(link, &my402IList->anchor, my402IList->anchor.next);
+    my402IList->num_members++;
+}
+
+void My402IListUnlink(My402IList* my402IList, My402IListLink* link){
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->prev = NULL;
+    link->next = NULL;
+    my402IList->num_members--;
+}
+
+void My402IListUnlinkAll(My402IList* my402IList){
+    My402IListLink* cur = my402IList->anchor.next;
+    while(cur != &my402IList->anchor){
+        My402IListLink* curNext = cur->next;
+        cur->prev = NULL;
+        cur->next = NULL;
+        cur = curNext;
+    }
+    My402IListInit(my402IList);
+}
+
+void My402IListInsertAfter(My402IList* my402IList, My402IListLink* link, My402IListLink* elem){
+    if(elem == NULL){
+        My402IListAppend(my402IList, link);
+        return;
+    }
+    linkBetween(link, elem, elem->next);
+    my402IList->num_members++;
+}
+
+void My402IListInsertBefore(My402IList* my402IList, My402IListLink* link, My402IListLink* elem){
+    if(elem == NULL){
+        My402IListPrepend(my402IList, link);
+        return;
+    }
+    linkBetween(link, elem->prev, elem);
+    my402IList->num_members++;
+}
+
+/*
+ * Moves the run first..last of src, count links long, into dst right after
+ * link, or to the end of dst if link is NULL. O(1): only the ends of the
+ * run are relinked. dst may be src, if link is not in the run.
+ */
+void My402IListSplice(My402IList* dst, My402IListLink* link, My402IList* src, My402IListLink* first, My402IListLink* last, int count){
+    if(count <= 0){
+        return;
+    }
+    first->prev->next = last->next;
+    last->next->prev = first->prev;
+    src->num_members -= count;
+
+    My402IListLink* prev = link != NULL ? link : dst->anchor.prev;
+    My402IListLink* next = prev->next;
+    prev->next = first;
+    first->prev = prev;
+    last->next = next;
+    next->prev = last;
+    dst->num_members += count;
+}
+
+/* moves every link of src to the end of dst */
+void My402IListConcat(My402IList* dst, My402IList* src){
+    My402IListSplice(dst, NULL, src, src->anchor.next, src->anchor.prev, src->num_members);
+}
+
+/*
+ * Moves link and everything after it to the end of rest. count is the
+ * number of links moved, or -1 to have them counted, which is O(n).
+ */
+void My402IListSplitAt(My402IList* my402IList, My402IListLink* link, My402IList* rest, int count){
+    if(count < 0){
+        count = 0;
+        for(My402IListLink* cur = link; cur != &my402IList->anchor; cur = cur->next){
+            count++;
+        }
+    }
+    My402IListSplice(rest, NULL, my402IList, link, my402IList->anchor.prev, count);
+}
+
+My402IListLink* My402IListFirst(My402IList* my402IList){
+    if(My402IListEmpty(my402IList)){
+        return NULL;
+    }
+    return my402IList->anchor.next;
+}
+
+My402IListLink* My402IListLast(My402IList* my402IList){
+    if(My402IListEmpty(my402IList)){
+        return NULL;
+    }
+    return my402IList->anchor.prev;
+}
+
+My402IListLink* My402IListNext(My402IList* my402IList, My402IListLink* cur){
+    if(cur->next == &my402IList->anchor){
+        return NULL;
+    }
+    return cur->next;
+}
+
+My402IListLink* My402IListPrev(My402IList* my402IList, My402IListLink* cur){
+    if(cur->prev == &my402IList->anchor){
+        return NULL;
+    }
+    return cur->prev;
+}
+
+void My402IListLinkInit(My402IListLink* link){
+    link->prev = NULL;
+    link->next = NULL;
+}
+
+int My402IListIsLinked(My402IListLink* link){
+    return link->next != NULL;
+}
+
+int My402IListInit(My402IList* my402IList){
+    memset(my402IList, 0, sizeof(My402IList));
+    my402IList->num_members = 0;
+    my402IList->anchor.prev = &my402IList->anchor;
+    my402IList->anchor.next = &my402IList->anchor;
+    return TRUE;
+}
@@ -0,0 +1,51 @@
+#ifndef _MY402ILIST_H_
+#define _MY402ILIST_H_
+
+#include <stddef.h>
+
+#include "cs402.h"
+
+/*
+ * Intrusive variant of My402List: the link is embedded in the object, so
+ * linking never allocates and the object is reached from its link with
+ * My402IListItem() instead of through a separate elem->obj pointer.
+ * A link can be on at most one list at a time.
+ */
+typedef struct tagMy402IListLink {
+    struct tagMy402IListLink *next;
+    struct tagMy402IListLink *prev;
+} My402IListLink;
+
+typedef struct tagMy402IList {
+    int num_members;
+    My402IListLink anchor;
+} My402IList;
+
+#define My402IListItem(link, type, member) \
+    ((type*)((char*)(link) - offsetof(type, member)))
+
+extern int  My402IListLength(My402IList*);
+extern int  My402IListEmpty(My402IList*);
+
+extern void My402IListAppend(My402IList*, My402IListLink*);
+extern void My402IListPrepend(My402IList*, My402IListLink*);
+extern void My402IListUnlink(My402IList*, My402IListLink*);
+extern void My402IListUnlinkAll(My402IList*);
+extern void My402IListInsertAfter(My402IList*, My402IListLink*, My402IListLink*);
+extern void My402IListInsertBefore(My402IList*, My402IListLink*, My402IListLink*);
+
+extern void My402IListSplice(My402IList*, My402IListLink*, My402IList*, My402IListLink*, My402IListLink*, int);
+extern void My402IListConcat(My402IList*, My402IList*);
+extern void My402IListSplitAt(My402IList*, My402IListLink*, My402IList*, int);
+
+extern My402IListLink *My402IListFirst(My402IList*);
+extern My402IListLink *My402IListLast(My402IList*);
+extern My402IListLink *My402IListNext(My402IList*, My402IListLink*);
+extern My402IListLink *My402IListPrev(My402IList*, My402IListLink*);
+
+extern void My402IListLinkInit(My402IListLink*);
+extern int  My402IListIsLinked(My402IListLink*);
+
+extern int My402IListInit(My402IList*);
+
+#endif /*_MY402ILIST_H_*/
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "my402ring.h"
+
+/* capacity is rounded up to a power of 2, at least 2 */
+int My402RingInit(My402Ring* ring, int capacity){
+    unsigned long long size = 2;
+    while(size < (unsigned long long)capacity){
+        size *= 2;
+    }
+    memset(ring, 0, sizeof(My402Ring));
+    ring->slots = (My402RingSlot*)malloc(sizeof(My402RingSlot) * size);
+    if(ring->slots == NULL){
+        return FALSE;
+    }
+    for(unsigned long long a = 0; a < size; a++){
+        ring->slots[a].seq = a;
+        ring->slots[a].obj = NULL;
+    }
+    ring->mask = size - 1;
+    return TRUE;
+}
+
+void My402RingFree(My402Ring* ring){
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+/*
+ * A slot at position pos holds seq == pos while it is free for that
+ * position's producer and seq == pos + 1 once its obj can be popped. The
+ * consumer hands it back for the next lap with seq == pos + capacity.
+ */
+int My402RingPush(My402Ring* ring, void* obj){
+    unsigned long long pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    while(TRUE){
+        My402RingSlot* slot = &ring->slots[pos & ring->mask];
+        long long diff = (long long)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if(diff == 0){
+            if(__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, TRUE, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)){
+                slot->obj = obj;
+                __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+                return TRUE;
+            }
+        }
+        else if(diff < 0){
+            return FALSE;
+        }
+        else{
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+int My402RingPop(My402Ring* ring, void** obj){
+    unsigned long long pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+    while(TRUE){
+        My402RingSlot* slot = &ring->slots[pos & ring->mask];
+        long long diff = (long long)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+        if(diff == 0){
+            if(__atomic_compare_exchange_n(&ring->dequeue_pos, &pos, pos + 1, TRUE, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)){
+                *obj = slot->obj;
+                __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+                return TRUE;
+            }
+        }
+        else if(diff < 0){
+            return FALSE;
+        }
+        else{
+            pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/* TRUE if every push so far has been matched by a pop; a push still in progress counts */
+int My402RingEmpty(My402Ring* ring){
+    unsigned long long dequeuePos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&ring->enqueue_pos, __ATOMIC_SEQ_CST) == dequeuePos;
+}
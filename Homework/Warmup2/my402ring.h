@@ -0,0 +1,35 @@
+#ifndef _MY402RING_H_
+#define _MY402RING_H_
+
+#include "cs402.h"
+
+/*
+ * Bounded lock-free multi-producer multi-consumer queue of object
+ * pointers. Each slot carries a sequence number that says whether it is
+ * ready for the producer or the consumer at a given position, so Push and
+ * Pop only compare-and-swap their own position counter. Push returns FALSE
+ * when the ring is full and Pop returns FALSE when it is empty; neither
+ * ever blocks.
+ */
+typedef struct tagMy402RingSlot {
+    unsigned long long seq;
+    void *obj;
+} My402RingSlot;
+
+typedef struct tagMy402Ring {
+    My402RingSlot *slots;
+    unsigned long long mask;
+
+    /* producers and consumers each spin on their own cache line */
+    unsigned long long enqueue_pos __attribute__((aligned(64)));
+    unsigned long long dequeue_pos __attribute__((aligned(64)));
+} My402Ring;
+
+extern int  My402RingInit(My402Ring*, int);
+extern void My402RingFree(My402Ring*);
+
+extern int  My402RingPush(My402Ring*, void*);
+extern int  My402RingPop(My402Ring*, void**);
+extern int  My402RingEmpty(My402Ring*);
+
+#endif /*_MY402RING_H_*/
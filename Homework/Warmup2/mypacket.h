@@ -1,7 +1,11 @@
 #ifndef _MYPACKET_H
 #define _MYPACKET_H
 
+#include "my402ilist.h"
+
 typedef struct {
+    My402IListLink link;
+
     int serviceType;
     int packetType;
     long long packetId;
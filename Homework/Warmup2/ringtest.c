@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+
+#include "my402ring.h"
+
+int gnProducers = 4;
+int gnConsumers = 4;
+int gnItems = 4000000;
+int gnCapacity = 64;
+
+My402Ring gRing;
+long long gnPopped = 0;
+unsigned char* gSeen = NULL;
+int gnBad = 0;
+
+void Usage(){
+    fprintf(stderr, "usage: ringtest [-producers=positive_integer] [-consumers=positive_integer] [-items=positive_integer] [-capacity=positive_integer]\n");
+    exit(1);
+}
+
+void ProcessOptions(int argc, char *argv[]){
+    for(int a = 1; a < argc; a++){
+        if(strncmp(argv[a], "-producers=", 11) == 0){
+            if(sscanf(&argv[a][11], "%d", &gnProducers) != 1 || gnProducers <= 0 || gnProducers > 256){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-consumers=", 11) == 0){
+            if(sscanf(&argv[a][11], "%d", &gnConsumers) != 1 || gnConsumers <= 0 || gnConsumers > 256){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-items=", 7) == 0){
+            if(sscanf(&argv[a][7], "%d", &gnItems) != 1 || gnItems <= 0){
+                Usage();
+            }
+        }
+        else if(strncmp(argv[a], "-capacity=", 10) == 0){
+            if(sscanf(&argv[a][10], "%d", &gnCapacity) != 1 || gnCapacity <= 0){
+                Usage();
+            }
+        }
+        else{
+            Usage();
+        }
+    }
+}
+
+/* producer a pushes items a, a + producers, a + 2 * producers, ... in that order */
+void* producerFunc(void* argv){
+    long producer = (long)argv;
+    for(long item = producer; item < gnItems; item += gnProducers){
+        while(!My402RingPush(&gRing, (void*)(item + 1))){
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Marks every item it pops as seen. The ring is FIFO, so one consumer must
+ * also see each producer's items in the order they were pushed.
+ */
+void* consumerFunc(void* argv){
+    long* lastItem = (long*)malloc(sizeof(long) * gnProducers);
+    if(lastItem == NULL){
+        fprintf(stderr, "Error malloc in consumerFunc.\n");
+        exit(1);
+    }
+    for(int a = 0; a < gnProducers; a++){
+        lastItem[a] = -1;
+    }
+    while(__atomic_load_n(&gnPopped, __ATOMIC_RELAXED) < gnItems){
+        void* obj = NULL;
+        if(!My402RingPop(&gRing, &obj)){
+            sched_yield();
+            continue;
+        }
+        long item = (long)obj - 1;
+        if(item < 0 || item >= gnItems || item <= lastItem[item % gnProducers]){
+            __atomic_store_n(&gnBad, 1, __ATOMIC_RELAXED);
+        }
+        else{
+            lastItem[item % gnProducers] = item;
+            __atomic_fetch_add(&gSeen[item], 1, __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_add(&gnPopped, 1, __ATOMIC_RELAXED);
+    }
+    free(lastItem);
+    return NULL;
+}
+
+int main(int argc, char *argv[]){
+    ProcessOptions(argc, argv);
+
+    gSeen = (unsigned char*)calloc(gnItems, 1);
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * (gnProducers + gnConsumers));
+    if(gSeen == NULL || threads == NULL || !My402RingInit(&gRing, gnCapacity)){
+        fprintf(stderr, "Error malloc in main.\n");
+        exit(1);
+    }
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    for(long a = 0; a < gnConsumers; a++){
+        pthread_create(&threads[a], NULL, consumerFunc, NULL);
+    }
+    for(long a = 0; a < gnProducers; a++){
+        pthread_create(&threads[gnConsumers + a], NULL, producerFunc, (void*)a);
+    }
+    for(int a = 0; a < gnProducers + gnConsumers; a++){
+        pthread_join(threads[a], NULL);
+    }
+    gettimeofday(&end, NULL);
+
+    long long lost = 0;
+    long long duplicated = 0;
+    for(int a = 0; a < gnItems; a++){
+        if(gSeen[a] == 0){
+            lost++;
+        }
+        else if(gSeen[a] > 1){
+            duplicated++;
+        }
+    }
+    void* obj = NULL;
+    if(My402RingPop(&gRing, &obj) || !My402RingEmpty(&gRing)){
+        gnBad = 1;
+    }
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    fprintf(stdout, "%d items, %d producers, %d consumers, capacity %llu: lost %lld, duplicated %lld, %s, %.0f items/s\n",
+            gnItems, gnProducers, gnConsumers, gRing.mask + 1, lost, duplicated, gnBad ? "out of order" : "in order",
+            gnItems / (seconds > 0 ? seconds : 1e-9));
+
+    My402RingFree(&gRing);
+    free(gSeen);
+    free(threads);
+    return lost == 0 && duplicated == 0 && !gnBad ? 0 : 1;
+}
@@ -4,13 +4,23 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <time.h>
+#include <errno.h>
 #include <math.h>
 #include <signal.h>
 #include <ctype.h>
 #include <limits.h>
+#include <sched.h>
 
 #include "my402list.h"
+#include "my402ilist.h"
 #include "mypacket.h"
+#include "my402ring.h"
+
+#define MAX_SERVERS 1024
+
+/* -q2 ring holds at most this many packets in Q2; arrivals into a full ring wait for a server */
+#define Q2_RING_CAPACITY 65536
 
 double sToUs;
 double msToUs;
@@ -23,6 +33,7 @@ double r;
 long long B;
 long long P;
 long long num;
+long long numServers;
 
 int numIndex;
 int lambdaIndex;
@@ -31,6 +42,8 @@ int rIndex;
 int BIndex;
 int PIndex;
 int tsfileIndex;
+int serversIndex;
+int q2Index;
 
 FILE* fileInput;
 long long lineNum;
@@ -46,21 +59,66 @@ long long allInterPacketTime;
 long long allPacketServiceTime;
 
 My402List inputQ;
-My402List outputQ;
-My402List Q1;
-My402List Q2;
+My402IList outputQ;
+My402IList Q1;
+My402IList Q2;
+My402IList* servedQ;
+
+int q2IsRing;
+My402Ring Q2Ring;
+int q2Sleepers;
 
 pthread_t packet;
 pthread_t token;
-pthread_t s1;
-pthread_t s2;
-
-pthread_mutex_t myLock;
-pthread_cond_t cv;
-
-struct timeval emulationStartTime;
-struct timeval emulationEndTime;
-struct timeval prePacketArriveTime;
+pthread_t* servers;
+int* serverIds;
+
+pthread_mutex_t q1Lock;
+pthread_mutex_t q2Lock;
+pthread_mutex_t traceLock;
+pthread_cond_t q2Cv;
+int q2Closed;
+
+struct timespec emulationStartTime;
+long long emulationEndTime;
+long long prePacketArriveTime;
+
+/*
+ * How late the packet and token threads woke up for each arrival, in
+ * microseconds past the absolute deadline they slept until.
+ */
+typedef struct {
+    long long* samples;
+    long long size;
+    long long capacity;
+} SchedError;
+
+SchedError packetSchedError;
+SchedError tokenSchedError;
+
+/*
+ * -sim runs the same emulation on one thread: arrivals, tokens and
+ * departures are events on a binary heap ordered by virtual time, and
+ * curTime() reads the virtual clock instead of CLOCK_MONOTONIC.
+ */
+#define SIM_PACKET 0
+#define SIM_TOKEN 1
+#define SIM_DEPART 2
+
+typedef struct {
+    long long time;
+    long long seq;
+    int type;
+    int server;
+    void* data;
+} SimEvent;
+
+int simMode;
+long long simClock;
+long long simEventSeq;
+SimEvent* simEvents;
+int simEventSize;
+int simEventCapacity;
 
 pthread_t sig;
 sigset_t mask;
@@ -82,8 +140,8 @@ double myMin(double num1, double num2){
     return num1 <= num2 ? num1 : num2;
 }
 
-long long calTimeDiff(struct timeval start, struct timeval end){
-    return (end.tv_sec - start.tv_sec) * sToUs + (end.tv_usec - start.tv_usec);
+long long calTimeDiff(struct timespec start, struct timespec end){
+    return (end.tv_sec - start.tv_sec) * sToUs + (end.tv_nsec - start.tv_nsec) / 1000;
 }
 
 void getTimeStampStr(char timeStampStr[], int strSize, long long timestamp){
@@ -100,14 +158,73 @@ void getTimeStampStr(char timeStampStr[], int strSize, long long timestamp){
     }
 }
 
+/* microseconds since the emulation began, on the virtual clock under -sim */
+long long curTime(){
+    if(simMode){
+        return simClock;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return calTimeDiff(emulationStartTime, now);
+}
+
+/* sleeps until deadline, in microseconds since the emulation began, and returns how late it woke up */
+long long sleepUntil(long long deadline){
+    struct timespec wakeTime = emulationStartTime;
+    wakeTime.tv_sec += deadline / (long long)sToUs;
+    wakeTime.tv_nsec += (deadline % (long long)sToUs) * 1000;
+    if(wakeTime.tv_nsec >= 1000000000){
+        wakeTime.tv_sec++;
+        wakeTime.tv_nsec -= 1000000000;
+    }
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL) == EINTR){
+    }
+    return curTime() - deadline;
+}
+
+void addSchedError(SchedError* schedError, long long lateness){
+    if(schedError->size == schedError->capacity){
+        schedError->capacity = schedError->capacity > 0 ? schedError->capacity * 2 : 1024;
+        schedError->samples = (long long*)realloc(schedError->samples, sizeof(long long) * schedError->capacity);
+        if(schedError->samples == NULL){
+            fprintf(stderr, "Error realloc in addSchedError.\n");
+            exit(1);
+        }
+    }
+    schedError->samples[schedError->size++] = lateness;
+}
+
+int compareLongLong(const void* a, const void* b){
+    long long num1 = *(const long long*)a;
+    long long num2 = *(const long long*)b;
+    return num1 < num2 ? -1 : (num1 > num2 ? 1 : 0);
+}
+
+void printSchedError(char* name, SchedError* schedError){
+    if(schedError->size == 0){
+        fprintf(stdout, "\t%s scheduling error = %s\n", name, "N/A, nothing was scheduled");
+        return;
+    }
+    double total = 0;
+    for(long long a = 0; a < schedError->size; a++){
+        total += schedError->samples[a];
+    }
+    qsort(schedError->samples, schedError->size, sizeof(long long), compareLongLong);
+    long long p99 = schedError->samples[(schedError->size * 99 + 99) / 100 - 1];
+    long long max = schedError->samples[schedError->size - 1];
+    fprintf(stdout, "\t%s scheduling error = mean %.6gms, p99 %.6gms, max %.6gms\n", name, total / schedError->size / msToUs, p99 / msToUs, max / msToUs);
+}
+
 void printUsageAndExit(){
-    fprintf(stderr, "usage: warmup2 [-lambda lambda] [-mu mu] [-r r] [-B B] [-P P] [-n num] [-t tsfile]\n");
+    fprintf(stderr, "usage: warmup2 [-lambda lambda] [-mu mu] [-r r] [-B B] [-P P] [-n num] [-t tsfile] [-servers N] [-q2 list|ring] [-sim]\n");
     exit(1);
 }
 
 MyPacket* createPacket(){
     MyPacket* myPacket = (MyPacket*)malloc(sizeof(MyPacket));
 
+    My402IListLinkInit(&myPacket->link);
+
     myPacket->serviceType = 0;
     myPacket->packetType = 0;
     myPacket->packetId = 0;
@@ -151,7 +268,8 @@ int isValidOption(char option[]){
     return strcmp("-lambda", option) == 0 || strcmp("-mu", option) == 0 || 
            strcmp("-r", option) == 0 || strcmp("-B", option) == 0 || 
            strcmp("-P", option) == 0 || strcmp("-n", option) == 0 || 
-           strcmp("-t", option) == 0;
+           strcmp("-t", option) == 0 || strcmp("-servers", option) == 0 ||
+           strcmp("-q2", option) == 0 || strcmp("-sim", option) == 0;
 }
 
 int isInteger(char optionValue[], int optionValueSize){
@@ -205,6 +323,12 @@ void checkField(char fieldStr[], int strSize, int lineNum){
 
 void checkInput(int argc, char* argv[]){
     for(int a = 1; a < argc; a += 2){
+        if(strcmp("-sim", argv[a]) == 0){
+            /* the only option without a value */
+            simMode = TRUE;
+            a--;
+            continue;
+        }
         if(!isValidOption(argv[a])){
             fprintf(stderr, "malformed command, %s is not a valid commandline option\n", argv[a]);
             printUsageAndExit();
@@ -213,15 +337,16 @@ void checkInput(int argc, char* argv[]){
             fprintf(stderr, "malformed command, value for %s is not given\n", argv[a]);
             printUsageAndExit();
         }
-        if(strcmp("-B", argv[a]) == 0 || strcmp("-P", argv[a]) == 0 || strcmp("-n", argv[a]) == 0){
+        if(strcmp("-B", argv[a]) == 0 || strcmp("-P", argv[a]) == 0 || strcmp("-n", argv[a]) == 0 || strcmp("-servers", argv[a]) == 0){
             if(!isInteger(argv[a + 1], strlen(argv[a + 1]))){
                 fprintf(stderr, "malformed command, %s value %s is not an integer\n", argv[a], argv[a + 1]);
                 printUsageAndExit();
             }
 
             long long val = atoll(argv[a + 1]);
-            if(val <= 0 || val > INT_MAX){
-                fprintf(stderr, "malformed command, %s value %s is not in valid range [1, %d]\n", argv[a], argv[a + 1], INT_MAX);
+            int maxVal = strcmp("-servers", argv[a]) == 0 ? MAX_SERVERS : INT_MAX;
+            if(val <= 0 || val > maxVal){
+                fprintf(stderr, "malformed command, %s value %s is not in valid range [1, %d]\n", argv[a], argv[a + 1], maxVal);
                 printUsageAndExit();
             }
 
@@ -234,6 +359,9 @@ void checkInput(int argc, char* argv[]){
             if(strcmp("-n", argv[a]) == 0){
                 numIndex = a;
             }
+            if(strcmp("-servers", argv[a]) == 0){
+                serversIndex = a;
+            }
         }
         if(strcmp("-lambda", argv[a]) == 0 || strcmp("-mu", argv[a]) == 0 || strcmp("-r", argv[a]) == 0){
             if(!isNumber(argv[a + 1], strlen(argv[a + 1]))){
@@ -251,6 +379,13 @@ void checkInput(int argc, char* argv[]){
                 rIndex = a;
             }
         }
+        if(strcmp("-q2", argv[a]) == 0){
+            if(strcmp("list", argv[a + 1]) != 0 && strcmp("ring", argv[a + 1]) != 0){
+                fprintf(stderr, "malformed command, %s value %s is not list or ring\n", argv[a], argv[a + 1]);
+                printUsageAndExit();
+            }
+            q2Index = a;
+        }
         if(strcmp("-t", argv[a]) == 0){
             tsfileIndex = a;
             if((fileInput = fopen(argv[a + 1], "r")) == NULL){
@@ -259,6 +394,11 @@ void checkInput(int argc, char* argv[]){
             }
         }
     }
+    /* nothing would ever pop a full ring while -sim's only thread pushes */
+    if(simMode && q2Index > 0 && strcmp("ring", argv[q2Index + 1]) == 0){
+        fprintf(stderr, "malformed command, -q2 ring cannot be used with -sim\n");
+        printUsageAndExit();
+    }
 }
 
 void readTsFileConfig(int argc, char* argv[]){
@@ -328,6 +468,12 @@ void readInput(int argc, char* argv[]){
     if(numIndex >= 0){
         num = atoll(argv[numIndex + 1]);
     }
+    if(serversIndex >= 0){
+        numServers = atoll(argv[serversIndex + 1]);
+    }
+    if(q2Index >= 0){
+        q2IsRing = strcmp("ring", argv[q2Index + 1]) == 0;
+    }
     if(tsfileIndex >= 0){
         readTsFileConfig(argc, argv);
     }
@@ -345,6 +491,7 @@ void setDefault(){
     B = 10;
     P = 3;
     num = 20;
+    numServers = 2;
 
     fileInput = NULL;
     lineNum = 0;
@@ -356,16 +503,30 @@ void setDefault(){
     BIndex = -1;
     PIndex = -1;
     tsfileIndex = -1;
+    serversIndex = -1;
+    q2Index = -1;
 
     packetId = 0;
     tokenId = 0;
     curTokenSize = 0;
     tokenDropSize = 0;
+    q2Closed = FALSE;
+    q2IsRing = FALSE;
+    memset(&packetSchedError, 0, sizeof(SchedError));
+    memset(&tokenSchedError, 0, sizeof(SchedError));
+    q2Sleepers = 0;
+
+    simMode = FALSE;
+    simClock = 0;
+    simEventSeq = 0;
+    simEvents = NULL;
+    simEventSize = 0;
+    simEventCapacity = 0;
 
     My402ListInit(&inputQ);
-    My402ListInit(&outputQ);
-    My402ListInit(&Q1);
-    My402ListInit(&Q2);
+    My402IListInit(&outputQ);
+    My402IListInit(&Q1);
+    My402IListInit(&Q2);
 
     sigemptyset(&mask);
 }
@@ -380,9 +541,31 @@ void init(){
     interTokenTime = myMin(interTokenTime, 10.0 * sToUs);
 
     inputQSize = num;
+
+    servers = (pthread_t*)malloc(sizeof(pthread_t) * numServers);
+    serverIds = (int*)malloc(sizeof(int) * numServers);
+    if(servers == NULL || serverIds == NULL){
+        fprintf(stderr, "Error malloc in init.\n");
+        exit(1);
+    }
+    servedQ = (My402IList*)malloc(sizeof(My402IList) * numServers);
+    if(servedQ == NULL){
+        fprintf(stderr, "Error malloc in init.\n");
+        exit(1);
+    }
+    for(int a = 0; a < numServers; a++){
+        serverIds[a] = a + 1;
+        My402IListInit(&servedQ[a]);
+    }
+    if(q2IsRing && !My402RingInit(&Q2Ring, (int)myMin(num, Q2_RING_CAPACITY))){
+        fprintf(stderr, "Error malloc in init.\n");
+        exit(1);
+    }
     
-    pthread_mutex_init(&myLock, NULL);
-    pthread_cond_init(&cv, NULL);
+    pthread_mutex_init(&q1Lock, NULL);
+    pthread_mutex_init(&q2Lock, NULL);
+    pthread_mutex_init(&traceLock, NULL);
+    pthread_cond_init(&q2Cv, NULL);
 
     sigaddset(&mask, SIGINT);
     sigprocmask(SIG_BLOCK, &mask, NULL);
@@ -403,6 +586,12 @@ void printConfig(int argc, char* argv[]){
     if(tsfileIndex >= 0){
         fprintf(stdout, "\ttsfile = %s\n", argv[tsfileIndex + 1]);
     }
+    if(serversIndex >= 0){
+        fprintf(stdout, "\tservers = %lld\n", numServers);
+    }
+    if(q2Index >= 0){
+        fprintf(stdout, "\tQ2 = %s\n", argv[q2Index + 1]);
+    }
     fprintf(stdout, "\n");
     // fprintf(stdout, "\tall inter-packet time = %lld\n", allInterPacketTime);
     // fprintf(stdout, "\tall inter-token time = %lld\n", interTokenTime);
@@ -414,15 +603,21 @@ void printStatics(){
     double totalRealServiceTime = 0;
     double totalTimeInQ1 = 0;
     double totalTimeInQ2 = 0;
-    double totalTimeInS1 = 0;
-    double totalTimeInS2 = 0;
     double totalTimeInSystem = 0;
 
+    /* serviceType is the server number, so the time at Sn is in totalTimeInS[n - 1] */
+    double* totalTimeInS = (double*)calloc(numServers, sizeof(double));
+    double* avgNumPacketInS = (double*)calloc(numServers, sizeof(double));
+    if(totalTimeInS == NULL || avgNumPacketInS == NULL){
+        fprintf(stderr, "Error calloc in printStatics.\n");
+        exit(1);
+    }
+
     long long packetServeSize = 0;
     long long packetDropSize = 0;
 
-    for(My402ListElem* cur = My402ListFirst(&outputQ); cur != NULL; cur = My402ListNext(&outputQ, cur)){
-        MyPacket* curPacket = (MyPacket*) cur->obj;
+    for(My402IListLink* cur = My402IListFirst(&outputQ); cur != NULL; cur = My402IListNext(&outputQ, cur)){
+        MyPacket* curPacket = My402IListItem(cur, MyPacket, link);
 
         totalRealInterPacketArriveTime += myRound(curPacket->realInterPacketArriveTime / msToUs, 3);
         
@@ -435,12 +630,7 @@ void printStatics(){
             totalTimeInQ1 += myRound((curPacket->leaveQ1Time - curPacket->enterQ1Time) / msToUs, 3);
             totalTimeInQ2 += myRound((curPacket->leaveQ2Time - curPacket->enterQ2Time) / msToUs, 3);
 
-            if(curPacket->serviceType == 1){
-                totalTimeInS1 += curRealServiceTime;
-            }
-            else{
-                totalTimeInS2 += curRealServiceTime;
-            }
+            totalTimeInS[curPacket->serviceType - 1] += curRealServiceTime;
 
             totalTimeInSystem += myRound((curPacket->endServiceTime - curPacket->arriveTime) / msToUs, 3);
         }
@@ -454,8 +644,6 @@ void printStatics(){
 
     double avgNumPacketInQ1 = -1;
     double avgNumPacketInQ2 = -1;
-    double avgNumPacketInS1 = -1;
-    double avgNumPacketInS2 = -1;
     
     double avgPacketSystemTime = -1;
     double stdevSystemTime = -1;
@@ -463,7 +651,7 @@ void printStatics(){
     double tokenDropProb = -1;
     double packetDropProb = -1;
     
-    long long totalEmulationTime = calTimeDiff(emulationStartTime, emulationEndTime);
+    long long totalEmulationTime = emulationEndTime;
 
     if(num > 0){
         avgRealInterPacketArriveTime = totalRealInterPacketArriveTime / num;
@@ -474,8 +662,8 @@ void printStatics(){
             avgPacketSystemTime = totalTimeInSystem / packetServeSize;
 
             double variance = 0;
-            for(My402ListElem* cur = My402ListFirst(&outputQ); cur != NULL; cur = My402ListNext(&outputQ, cur)){
-                MyPacket* curPacket = (MyPacket*) cur->obj;
+            for(My402IListLink* cur = My402IListFirst(&outputQ); cur != NULL; cur = My402IListNext(&outputQ, cur)){
+                MyPacket* curPacket = My402IListItem(cur, MyPacket, link);
                 if(curPacket->packetType == 1){
                     double curSystemTime = myRound((curPacket->endServiceTime - curPacket->arriveTime) / msToUs , 3);
                     variance += pow(curSystemTime - avgPacketSystemTime, 2);
@@ -490,8 +678,9 @@ void printStatics(){
         double totalEmulationTimeMS = myRound(totalEmulationTime / msToUs, 3);
         avgNumPacketInQ1 = totalTimeInQ1 / totalEmulationTimeMS;
         avgNumPacketInQ2 = totalTimeInQ2 / totalEmulationTimeMS;
-        avgNumPacketInS1 = totalTimeInS1 / totalEmulationTimeMS;
-        avgNumPacketInS2 = totalTimeInS2 / totalEmulationTimeMS;
+        for(int a = 0; a < numServers; a++){
+            avgNumPacketInS[a] = totalTimeInS[a] / totalEmulationTimeMS;
+        }
     }
 
     if(tokenId > 0){
@@ -520,14 +709,16 @@ void printStatics(){
     if(totalEmulationTime > 0){
         fprintf(stdout, "\taverage number of packets in Q1 = %.6g\n", avgNumPacketInQ1);
         fprintf(stdout, "\taverage number of packets in Q2 = %.6g\n", avgNumPacketInQ2);
-        fprintf(stdout, "\taverage number of packets in S1 = %.6g\n", avgNumPacketInS1);
-        fprintf(stdout, "\taverage number of packets in S2 = %.6g\n", avgNumPacketInS2);
+        for(int a = 0; a < numServers; a++){
+            fprintf(stdout, "\taverage number of packets in S%d = %.6g\n", a + 1, avgNumPacketInS[a]);
+        }
     }
     else{
         fprintf(stdout, "\taverage number of packets in Q1 = %s\n", "N/A, no emulation time");
         fprintf(stdout, "\taverage number of packets in Q2 = %s\n", "N/A, no emulation time");
-        fprintf(stdout, "\taverage number of packets in S1 = %s\n", "N/A, no emulation time");
-        fprintf(stdout, "\taverage number of packets in S2 = %s\n", "N/A, no emulation time");
+        for(int a = 0; a < numServers; a++){
+            fprintf(stdout, "\taverage number of packets in S%d = %s\n", a + 1, "N/A, no emulation time");
+        }
     }
 
     fprintf(stdout, "\n");
@@ -556,263 +747,385 @@ void printStatics(){
     else{
         fprintf(stdout, "\tpacket drop probability = %s\n", "N/A, no packet was served");
     }
+
+    /* -sim runs on a virtual clock, which is never late */
+    if(!simMode){
+        fprintf(stdout, "\n");
+        printSchedError("packet arrival", &packetSchedError);
+        printSchedError("token arrival", &tokenSchedError);
+    }
+
+    free(totalTimeInS);
+    free(avgNumPacketInS);
 }
 
 void cleanUp(){
-    My402ListUnlinkAll(&outputQ);
+    My402IListUnlinkAll(&outputQ);
     if(tsfileIndex >= 0){
         fclose(fileInput);
     }
+    free(simEvents);
+    free(servers);
+    free(serverIds);
+    free(servedQ);
+    free(packetSchedError.samples);
+    free(tokenSchedError.samples);
+    if(q2IsRing){
+        My402RingFree(&Q2Ring);
+    }
 }
 
-void* packetFunc(void* argv){
-    while(inputQSize > 0){
-        PacketData* packetData = createPacketData();
-        if(tsfileIndex >= 0){
-            readTsFileData(packetData);
-        }
-
-        if(packetData->interPcketTime > 0){
-            usleep(packetData->interPcketTime);
-        }
-        
-        pthread_mutex_lock(&myLock);
-
-        if(inputQSize <= 0){
-            pthread_mutex_unlock(&myLock);
-            continue;
-        }
-
-        inputQSize--;
-        MyPacket* inputPacket = createPacket();
-        initPacket(inputPacket, packetData);
-
-        struct timeval curArriveTime;
-        gettimeofday(&curArriveTime, NULL);
-        
-        char timeStampStr[timeStampStrSize];
-        getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curArriveTime));
+/*
+ * Locking, always taken in this order:
+ *     q1Lock     Q1, the token bucket, inputQSize, packetId, prePacketArriveTime
+ *     q2Lock     Q2, outputQ, q2Closed; q2Cv wakes one server per packet
+ *     traceLock  the clock read and print of one trace line, so the
+ *                timestamps in the trace never go backwards
+ * q2Closed is set once no packet can reach Q2 anymore, and then every
+ * server is woken to finish. Each server appends the packets it serves to
+ * its own servedQ, which main moves to outputQ at the end.
+ *
+ * With -q2 ring, Q2 is the lock-free Q2Ring instead: servers pop from it
+ * without a lock and only take q2Lock to park on q2Cv when it is empty.
+ *
+ * The steps below change the queues and print the trace. The packet and
+ * token threads call them with q1Lock held; -sim calls them from its
+ * event loop.
+ */
+
+long long traceBegin(){
+    pthread_mutex_lock(&traceLock);
+    return curTime();
+}
 
-        long long curArriveTimeDiff = calTimeDiff(prePacketArriveTime, curArriveTime);
-        double curArriveTimeDiffMS = curArriveTimeDiff / msToUs;
+void traceEnd(){
+    pthread_mutex_unlock(&traceLock);
+}
 
-        inputPacket->arriveTime = calTimeDiff(emulationStartTime, curArriveTime);
-        inputPacket->realInterPacketArriveTime = curArriveTimeDiff;
+/* closes Q2 if nothing is left to arrive in it; q1Lock must be held */
+void closeQ2IfDone(){
+    if(inputQSize <= 0 && My402IListEmpty(&Q1)){
+        pthread_mutex_lock(&q2Lock);
+        q2Closed = TRUE;
+        pthread_cond_broadcast(&q2Cv);
+        pthread_mutex_unlock(&q2Lock);
+    }
+}
 
-        prePacketArriveTime.tv_sec = curArriveTime.tv_sec;
-        prePacketArriveTime.tv_usec = curArriveTime.tv_usec;
-        
-        if(inputPacket->tokenNeed > B){
-            inputPacket->packetType = 2;
-            My402ListAppend(&outputQ, inputPacket);
+void q2Put(MyPacket* packet){
+    if(!q2IsRing){
+        pthread_mutex_lock(&q2Lock);
+        My402IListAppend(&Q2, &packet->link);
+        pthread_cond_signal(&q2Cv);
+        pthread_mutex_unlock(&q2Lock);
+        return;
+    }
+    while(!My402RingPush(&Q2Ring, packet)){
+        sched_yield();
+    }
+    /* pairs with the fence in q2Get: either this sees the sleeper or the sleeper sees the packet */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&q2Sleepers, __ATOMIC_RELAXED) > 0){
+        pthread_mutex_lock(&q2Lock);
+        pthread_cond_signal(&q2Cv);
+        pthread_mutex_unlock(&q2Lock);
+    }
+}
 
-            fprintf(stdout, "%sms: p%lld arrives, needs %lld tokens, inter-arrival time = %.3fms, dropped\n", timeStampStr, inputPacket->packetId, inputPacket->tokenNeed, curArriveTimeDiffMS);
+/*
+ * Takes the first packet of Q2. If Q2 is empty it returns NULL right away
+ * unless wait is TRUE, in which case it parks until there is a packet or
+ * Q2 is closed.
+ */
+MyPacket* q2Get(int wait){
+    if(!q2IsRing){
+        MyPacket* packet = NULL;
+        pthread_mutex_lock(&q2Lock);
+        while(wait && My402IListEmpty(&Q2) && !q2Closed){
+            pthread_cond_wait(&q2Cv, &q2Lock);
         }
-        else{
-            fprintf(stdout, "%sms: p%lld arrives, needs %lld tokens, inter-arrival time = %.3fms\n", timeStampStr, inputPacket->packetId, inputPacket->tokenNeed, curArriveTimeDiffMS);
-
-            My402ListAppend(&Q1, inputPacket);
+        if(!My402IListEmpty(&Q2)){
+            My402IListLink* link = My402IListFirst(&Q2);
+            My402IListUnlink(&Q2, link);
+            packet = My402IListItem(link, MyPacket, link);
+        }
+        pthread_mutex_unlock(&q2Lock);
+        return packet;
+    }
+    void* obj = NULL;
+    while(!My402RingPop(&Q2Ring, &obj)){
+        if(!wait){
+            return NULL;
+        }
+        pthread_mutex_lock(&q2Lock);
+        __atomic_add_fetch(&q2Sleepers, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        while(My402RingEmpty(&Q2Ring) && !q2Closed){
+            pthread_cond_wait(&q2Cv, &q2Lock);
+        }
+        __atomic_sub_fetch(&q2Sleepers, 1, __ATOMIC_RELAXED);
+        int done = q2Closed && My402RingEmpty(&Q2Ring);
+        pthread_mutex_unlock(&q2Lock);
+        if(done){
+            return NULL;
+        }
+    }
+    return (MyPacket*)obj;
+}
 
-            struct timeval curEnterQ1Time;
-            gettimeofday(&curEnterQ1Time, NULL);
+/* moves the first packet of Q1 to Q2 if the bucket has its tokens */
+void moveQ1ToQ2(){
+    if(My402IListEmpty(&Q1)){
+        return;
+    }
+    My402IListLink* link = My402IListFirst(&Q1);
+    MyPacket* q1Packet = My402IListItem(link, MyPacket, link);
+    if(curTokenSize < q1Packet->tokenNeed){
+        return;
+    }
 
-            getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curEnterQ1Time));
+    My402IListUnlink(&Q1, link);
+    curTokenSize -= q1Packet->tokenNeed;
 
-            long long curEnterQ1TimeDiff = calTimeDiff(emulationStartTime, curEnterQ1Time);
-            inputPacket->enterQ1Time = curEnterQ1TimeDiff;
-            fprintf(stdout, "%sms: p%lld enters Q1\n", timeStampStr, inputPacket->packetId);
+    char timeStampStr[timeStampStrSize];
+    q1Packet->leaveQ1Time = traceBegin();
+    getTimeStampStr(timeStampStr, timeStampStrSize, q1Packet->leaveQ1Time);
+    double timeInQ1 = (q1Packet->leaveQ1Time - q1Packet->enterQ1Time) / msToUs;
 
-            if(!My402ListEmpty(&Q1)){
-                My402ListElem* elem = My402ListFirst(&Q1);
-                MyPacket* q1Packet = (MyPacket*)elem->obj;
+    fprintf(stdout, "%sms: p%lld leaves Q1, time in Q1 = %.3fms, token bucket now has %lld tokens\n", timeStampStr, q1Packet->packetId, timeInQ1, curTokenSize);
+    traceEnd();
 
-                if(curTokenSize >= q1Packet->tokenNeed){
-                    My402ListUnlink(&Q1, elem);
-                    curTokenSize -= q1Packet->tokenNeed;
+    /* a server may take the packet as soon as it is in Q2, so it is stamped first */
+    q1Packet->enterQ2Time = traceBegin();
+    getTimeStampStr(timeStampStr, timeStampStrSize, q1Packet->enterQ2Time);
 
-                    struct timeval curLeaveQ1Time;
-                    gettimeofday(&curLeaveQ1Time, NULL);
+    fprintf(stdout, "%sms: p%lld enters Q2\n", timeStampStr, q1Packet->packetId);
+    traceEnd();
 
-                    getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curLeaveQ1Time));
+    q2Put(q1Packet);
+}
 
-                    long long curLeaveQ1TimeDiff = calTimeDiff(emulationStartTime, curLeaveQ1Time);
-                    q1Packet->leaveQ1Time = curLeaveQ1TimeDiff;
-                    double timeInQ1 = (q1Packet->leaveQ1Time - q1Packet->enterQ1Time) / msToUs;
+void packetArrives(PacketData* packetData){
+    inputQSize--;
+    MyPacket* inputPacket = createPacket();
+    initPacket(inputPacket, packetData);
 
-                    fprintf(stdout, "%sms: p%lld leaves Q1, time in Q1 = %.3fms, token bucket now has %lld tokens\n", timeStampStr, q1Packet->packetId, timeInQ1, curTokenSize);
+    long long curArriveTime = traceBegin();
 
-                    My402ListAppend(&Q2, q1Packet);
-                    
-                    struct timeval curEnterQ2Time;
-                    gettimeofday(&curEnterQ2Time, NULL);
+    char timeStampStr[timeStampStrSize];
+    getTimeStampStr(timeStampStr, timeStampStrSize, curArriveTime);
 
-                    getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curEnterQ2Time));
+    long long curArriveTimeDiff = curArriveTime - prePacketArriveTime;
+    double curArriveTimeDiffMS = curArriveTimeDiff / msToUs;
 
-                    long long curEnterQ2TimeDiff = calTimeDiff(emulationStartTime, curEnterQ2Time);
-                    q1Packet->enterQ2Time = curEnterQ2TimeDiff;
+    inputPacket->arriveTime = curArriveTime;
+    inputPacket->realInterPacketArriveTime = curArriveTimeDiff;
 
-                    fprintf(stdout, "%sms: p%lld enters Q2\n", timeStampStr, q1Packet->packetId);
+    prePacketArriveTime = curArriveTime;
 
-                    pthread_cond_broadcast(&cv);
-                }
-            }
-        }
-        
-        pthread_mutex_unlock(&myLock);
-    }
-    // fprintf(stdout, "inputQSize: %lld, Q1: %d, Q2: %d, outputQ: %d\n", inputQSize, My402ListLength(&Q1), My402ListLength(&Q2), My402ListLength(&outputQ));
-    // fprintf(stdout, "packet thread end!!!\n");
-    return NULL;
-}
+    if(inputPacket->tokenNeed > B){
+        inputPacket->packetType = 2;
 
-void* tokenFunc(void* argv){
-    while(inputQSize > 0 || !My402ListEmpty(&Q1)){
-        if(interTokenTime > 0){
-            usleep(interTokenTime);
-        }
+        fprintf(stdout, "%sms: p%lld arrives, needs %lld tokens, inter-arrival time = %.3fms, dropped\n", timeStampStr, inputPacket->packetId, inputPacket->tokenNeed, curArriveTimeDiffMS);
+        traceEnd();
 
-        pthread_mutex_lock(&myLock);
+        pthread_mutex_lock(&q2Lock);
+        My402IListAppend(&outputQ, &inputPacket->link);
+        pthread_mutex_unlock(&q2Lock);
 
-        if(inputQSize <= 0 && My402ListEmpty(&Q1)){
-            pthread_mutex_unlock(&myLock);
-            continue;
-        }
-        
-        tokenId++;
+        closeQ2IfDone();
+        return;
+    }
 
-        struct timeval tokenArriveTime;
-        gettimeofday(&tokenArriveTime, NULL);
+    fprintf(stdout, "%sms: p%lld arrives, needs %lld tokens, inter-arrival time = %.3fms\n", timeStampStr, inputPacket->packetId, inputPacket->tokenNeed, curArriveTimeDiffMS);
+    traceEnd();
 
-        char timeStampStr[timeStampStrSize];
-        getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, tokenArriveTime));
+    My402IListAppend(&Q1, &inputPacket->link);
 
-        if(curTokenSize >= B){
-            tokenDropSize++;
-            fprintf(stdout, "%sms: token t%lld arrives, dropped\n", timeStampStr, tokenId);
-        }
-        else{
-            curTokenSize++;
-            fprintf(stdout, "%sms: token t%lld arrives, token bucket now has %lld tokens\n", timeStampStr, tokenId, curTokenSize);
-        }
-    
-        if(!My402ListEmpty(&Q1)){
-            My402ListElem* elem = My402ListFirst(&Q1);
-            MyPacket* q1Packet = (MyPacket*)elem->obj;
+    inputPacket->enterQ1Time = traceBegin();
+    getTimeStampStr(timeStampStr, timeStampStrSize, inputPacket->enterQ1Time);
+    fprintf(stdout, "%sms: p%lld enters Q1\n", timeStampStr, inputPacket->packetId);
+    traceEnd();
 
-            if(curTokenSize >= q1Packet->tokenNeed){
-                My402ListUnlink(&Q1, elem);
-                curTokenSize -= q1Packet->tokenNeed;
+    moveQ1ToQ2();
+    closeQ2IfDone();
+}
 
-                struct timeval curLeaveQ1Time;
-                gettimeofday(&curLeaveQ1Time, NULL);
+void tokenArrives(){
+    tokenId++;
 
-                getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curLeaveQ1Time));
+    char timeStampStr[timeStampStrSize];
+    getTimeStampStr(timeStampStr, timeStampStrSize, traceBegin());
 
-                long long curLeaveQ1TimeDiff = calTimeDiff(emulationStartTime, curLeaveQ1Time);
-                q1Packet->leaveQ1Time = curLeaveQ1TimeDiff;
-                double timeInQ1 = (q1Packet->leaveQ1Time - q1Packet->enterQ1Time) / msToUs;
+    if(curTokenSize >= B){
+        tokenDropSize++;
+        fprintf(stdout, "%sms: token t%lld arrives, dropped\n", timeStampStr, tokenId);
+    }
+    else{
+        curTokenSize++;
+        fprintf(stdout, "%sms: token t%lld arrives, token bucket now has %lld tokens\n", timeStampStr, tokenId, curTokenSize);
+    }
+    traceEnd();
 
-                fprintf(stdout, "%sms: p%lld leaves Q1, time in Q1 = %.3fms, token bucket now has %lld tokens\n", timeStampStr, q1Packet->packetId, timeInQ1, curTokenSize);
+    moveQ1ToQ2();
+    closeQ2IfDone();
+}
 
-                My402ListAppend(&Q2, q1Packet);
-                
-                struct timeval curEnterQ2Time;
-                gettimeofday(&curEnterQ2Time, NULL);
+/* q2Packet, just taken from Q2, goes into service at server Sn */
+void beginService(MyPacket* q2Packet, int serverId){
+    char timeStampStr[timeStampStrSize];
+    q2Packet->leaveQ2Time = traceBegin();
+    getTimeStampStr(timeStampStr, timeStampStrSize, q2Packet->leaveQ2Time);
+    double timeInQ2 = (q2Packet->leaveQ2Time - q2Packet->enterQ2Time) / msToUs;
 
-                getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curEnterQ2Time));
+    fprintf(stdout, "%sms: p%lld leaves Q2, time in Q2 = %.3fms\n", timeStampStr, q2Packet->packetId, timeInQ2);
+    traceEnd();
 
-                long long curEnterQ2TimeDiff = calTimeDiff(emulationStartTime, curEnterQ2Time);
-                q1Packet->enterQ2Time = curEnterQ2TimeDiff;
+    q2Packet->packetType = 1;
+    q2Packet->serviceType = serverId;
 
-                fprintf(stdout, "%sms: p%lld enters Q2\n", timeStampStr, q1Packet->packetId);
+    My402IListAppend(&servedQ[serverId - 1], &q2Packet->link);
 
-                pthread_cond_broadcast(&cv);
-            }
-        }
+    q2Packet->beginServiceTime = traceBegin();
+    getTimeStampStr(timeStampStr, timeStampStrSize, q2Packet->beginServiceTime);
+    double packetServiceTime = q2Packet->packetServiceTime / msToUs;
 
-        pthread_mutex_unlock(&myLock);
-    }
-    // fprintf(stdout, "inputQSize: %lld, Q1: %d, Q2: %d, outputQ: %d\n", inputQSize, My402ListLength(&Q1), My402ListLength(&Q2), My402ListLength(&outputQ));
-    // fprintf(stdout, "token thread end!!!\n");
-    return NULL;
+    fprintf(stdout, "%sms: p%lld begins service at S%d, requesting %.0fms of service\n", timeStampStr, q2Packet->packetId, serverId, packetServiceTime);
+    traceEnd();
 }
 
-void* serverFunc(void* argv){
-    char* name = (char*) argv;
-    while(inputQSize > 0 || !My402ListEmpty(&Q1) || !My402ListEmpty(&Q2)){
-        pthread_mutex_lock(&myLock);
-
-        while(My402ListEmpty(&Q2) && inputQSize > 0 && !My402ListEmpty(&Q1)){
-            pthread_cond_wait(&cv, &myLock);
-        }
-
-        MyPacket* q2Packet = NULL;
-        char timeStampStr[timeStampStrSize];
+void endService(MyPacket* q2Packet){
+    char timeStampStr[timeStampStrSize];
+    q2Packet->endServiceTime = traceBegin();
+    getTimeStampStr(timeStampStr, timeStampStrSize, q2Packet->endServiceTime);
+    double curRealServiceTime = (q2Packet->endServiceTime - q2Packet->beginServiceTime) / msToUs;
+    double curSystemTime = (q2Packet->endServiceTime - q2Packet->arriveTime) / msToUs;
 
-        if(!My402ListEmpty(&Q2)){
-            My402ListElem* elem = My402ListFirst(&Q2);
-            q2Packet = (MyPacket*)elem->obj;
+    fprintf(stdout, "%sms: p%lld departs from S%d, service time = %.3fms, time in system = %.3fms\n", timeStampStr, q2Packet->packetId, q2Packet->serviceType, curRealServiceTime, curSystemTime);
+    traceEnd();
+}
 
-            My402ListUnlink(&Q2, elem);
+void removePacket(MyPacket* packet, char* queueName){
+    char timeStampStr[timeStampStrSize];
+    packet->packetType = 3;
 
-            struct timeval curLeaveQ2Time;
-            gettimeofday(&curLeaveQ2Time, NULL);
+    getTimeStampStr(timeStampStr, timeStampStrSize, traceBegin());
+    fprintf(stdout, "%sms: p%lld removed from %s\n", timeStampStr, packet->packetId, queueName);
+    traceEnd();
+}
 
-            getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curLeaveQ2Time));
+/* SIGINT: reports and removes every packet still in Q1 or Q2, and stops new arrivals */
+void removeAllPackets(){
+    pthread_mutex_lock(&q1Lock);
+    pthread_mutex_lock(&q2Lock);
 
-            long long curLeaveQ2TimeDiff = calTimeDiff(emulationStartTime, curLeaveQ2Time);
-            q2Packet->leaveQ2Time = curLeaveQ2TimeDiff;
-            double timeInQ2 = (q2Packet->leaveQ2Time - q2Packet->enterQ2Time) / msToUs;
+    char timeStampStr[timeStampStrSize];
+    getTimeStampStr(timeStampStr, timeStampStrSize, traceBegin());
 
-            fprintf(stdout, "%sms: p%lld leaves Q2, time in Q2 = %.3fms\n", timeStampStr, q2Packet->packetId, timeInQ2);
+    fprintf(stdout, "\n%sms: SIGINT caught, no new packets or tokens will be allowed\n", timeStampStr);
+    traceEnd();
 
-            q2Packet->packetType = 1;
-            if(strcmp("S1", name) == 0){
-                q2Packet->serviceType = 1;
-            }
-            else{
-                q2Packet->serviceType = 2;
-            }
+    /* mark and report every packet, then move each queue over to outputQ in one splice */
+    for(My402IListLink* link = My402IListFirst(&Q1); link != NULL; link = My402IListNext(&Q1, link)){
+        removePacket(My402IListItem(link, MyPacket, link), "Q1");
+    }
+    My402IListConcat(&outputQ, &Q1);
+    for(My402IListLink* link = My402IListFirst(&Q2); link != NULL; link = My402IListNext(&Q2, link)){
+        removePacket(My402IListItem(link, MyPacket, link), "Q2");
+    }
+    My402IListConcat(&outputQ, &Q2);
+    /* servers may still be popping the ring, but each packet comes out exactly once */
+    void* obj = NULL;
+    while(q2IsRing && My402RingPop(&Q2Ring, &obj)){
+        removePacket((MyPacket*)obj, "Q2");
+        My402IListAppend(&outputQ, &((MyPacket*)obj)->link);
+    }
+    inputQSize = 0;
 
-            My402ListAppend(&outputQ, q2Packet);
-            
-            struct timeval curBeginServiceTime;
-            gettimeofday(&curBeginServiceTime, NULL);
+    q2Closed = TRUE;
+    pthread_cond_broadcast(&q2Cv);
 
-            getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curBeginServiceTime));
+    pthread_mutex_unlock(&q2Lock);
+    pthread_mutex_unlock(&q1Lock);
+}
 
-            long long curBeginServiceTimeDiff = calTimeDiff(emulationStartTime, curBeginServiceTime);
-            q2Packet->beginServiceTime = curBeginServiceTimeDiff;
-            double packetServiceTime = q2Packet->packetServiceTime / msToUs;
+/*
+ * The packet and token threads sleep until absolute deadlines, each one
+ * interval after the previous deadline rather than after the previous
+ * wakeup, so time spent waiting for locks and printing does not add up
+ * as drift.
+ */
+void* packetFunc(void* argv){
+    int running = TRUE;
+    long long deadline = 0;
+    while(running){
+        PacketData* packetData = createPacketData();
+        if(tsfileIndex >= 0){
+            readTsFileData(packetData);
+        }
 
-            fprintf(stdout, "%sms: p%lld begins service at %s, requesting %.0fms of service\n", timeStampStr, q2Packet->packetId, name, packetServiceTime);
+        /* a 0 interval means as fast as possible, which has no deadline to miss */
+        deadline += packetData->interPcketTime;
+        long long lateness = sleepUntil(deadline);
+        if(packetData->interPcketTime > 0){
+            addSchedError(&packetSchedError, lateness);
+        }
+        
+        pthread_mutex_lock(&q1Lock);
 
-            pthread_cond_broadcast(&cv);
+        if(inputQSize > 0){
+            packetArrives(packetData);
         }
+        running = inputQSize > 0;
         
-        pthread_mutex_unlock(&myLock);
+        pthread_mutex_unlock(&q1Lock);
+        free(packetData);
+    }
+    // fprintf(stdout, "inputQSize: %lld, Q1: %d, Q2: %d, outputQ: %d\n", inputQSize, My402ListLength(&Q1), My402ListLength(&Q2), My402ListLength(&outputQ));
+    // fprintf(stdout, "packet thread end!!!\n");
+    return NULL;
+}
 
-        if(q2Packet != NULL){
-            if(q2Packet->packetServiceTime > 0){
-                usleep(q2Packet->packetServiceTime);
-            }
+void* tokenFunc(void* argv){
+    int running = TRUE;
+    long long deadline = 0;
+    while(running){
+        deadline += interTokenTime;
+        long long lateness = sleepUntil(deadline);
+        if(interTokenTime > 0){
+            addSchedError(&tokenSchedError, lateness);
+        }
 
-            struct timeval curEndServiceTime;
-            gettimeofday(&curEndServiceTime, NULL);
+        pthread_mutex_lock(&q1Lock);
 
-            getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curEndServiceTime));
+        if(inputQSize > 0 || !My402IListEmpty(&Q1)){
+            tokenArrives();
+        }
+        running = inputQSize > 0 || !My402IListEmpty(&Q1);
 
-            long long curEndServiceTimeDiff = calTimeDiff(emulationStartTime, curEndServiceTime);
-            q2Packet->endServiceTime = curEndServiceTimeDiff;
-            double curRealServiceTime = (q2Packet->endServiceTime - q2Packet->beginServiceTime) / msToUs;
-            double curSystemTime = (q2Packet->endServiceTime - q2Packet->arriveTime) / msToUs;
+        pthread_mutex_unlock(&q1Lock);
+    }
+    // fprintf(stdout, "inputQSize: %lld, Q1: %d, Q2: %d, outputQ: %d\n", inputQSize, My402ListLength(&Q1), My402ListLength(&Q2), My402ListLength(&outputQ));
+    // fprintf(stdout, "token thread end!!!\n");
+    return NULL;
+}
 
-            fprintf(stdout, "%sms: p%lld departs from %s, service time = %.3fms, time in system = %.3fms\n", timeStampStr, q2Packet->packetId, name, curRealServiceTime, curSystemTime);
+void* serverFunc(void* argv){
+    int serverId = *(int*) argv;
+    while(TRUE){
+        MyPacket* q2Packet = q2Get(TRUE);
+        if(q2Packet == NULL){
+            break;
         }
-        
+        beginService(q2Packet, serverId);
+
+        if(q2Packet->packetServiceTime > 0){
+            usleep(q2Packet->packetServiceTime);
+        }
+        endService(q2Packet);
     }
     // fprintf(stdout, "inputQSize: %lld, Q1: %d, Q2: %d, outputQ: %d\n", inputQSize, My402ListLength(&Q1), My402ListLength(&Q2), My402ListLength(&outputQ));
-    // fprintf(stdout, "%s thread end!!!\n", name);
+    // fprintf(stdout, "S%d thread end!!!\n", serverId);
     return NULL;
 }
 
@@ -821,50 +1134,129 @@ void* signalFunc(void* argv){
     while(mySignal < 0){
         sigwait(&mask, &mySignal);
         
-        pthread_mutex_lock(&myLock);
-        
-        struct timeval curSignalCatchTime;
-        gettimeofday(&curSignalCatchTime, NULL);
+        removeAllPackets();
+    }
+    // fprintf(stdout, "inputQSize: %lld, Q1: %d, Q2: %d, outputQ: %d\n", inputQSize, My402ListLength(&Q1), My402ListLength(&Q2), My402ListLength(&outputQ));
+    // fprintf(stdout, "signal thread end!!!\n");
+    return NULL;
+}
+
+/* events at the same virtual time run in the order they were scheduled */
+int simEventBefore(SimEvent* event1, SimEvent* event2){
+    if(event1->time != event2->time){
+        return event1->time < event2->time;
+    }
+    return event1->seq < event2->seq;
+}
 
-        char timeStampStr[timeStampStrSize];
-        getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curSignalCatchTime));
+void simSchedule(int type, long long time, int server, void* data){
+    if(simEventSize == simEventCapacity){
+        simEventCapacity = simEventCapacity > 0 ? simEventCapacity * 2 : 16;
+        simEvents = (SimEvent*)realloc(simEvents, sizeof(SimEvent) * simEventCapacity);
+        if(simEvents == NULL){
+            fprintf(stderr, "Error realloc in simSchedule.\n");
+            exit(1);
+        }
+    }
+    SimEvent event = {time, simEventSeq++, type, server, data};
+    int a = simEventSize++;
+    while(a > 0 && simEventBefore(&event, &simEvents[(a - 1) / 2])){
+        simEvents[a] = simEvents[(a - 1) / 2];
+        a = (a - 1) / 2;
+    }
+    simEvents[a] = event;
+}
 
-        fprintf(stdout, "\n%sms: SIGINT caught, no new packets or tokens will be allowed\n", timeStampStr);
+SimEvent simNextEvent(){
+    SimEvent first = simEvents[0];
+    SimEvent last = simEvents[--simEventSize];
+    int a = 0;
+    while(2 * a + 1 < simEventSize){
+        int b = 2 * a + 1;
+        if(b + 1 < simEventSize && simEventBefore(&simEvents[b + 1], &simEvents[b])){
+            b++;
+        }
+        if(!simEventBefore(&simEvents[b], &last)){
+            break;
+        }
+        simEvents[a] = simEvents[b];
+        a = b;
+    }
+    simEvents[a] = last;
+    return first;
+}
+
+/* schedules the next packet arrival, interPcketTime after the previous one */
+void simSchedulePacket(){
+    PacketData* packetData = createPacketData();
+    if(tsfileIndex >= 0){
+        readTsFileData(packetData);
+    }
+    simSchedule(SIM_PACKET, simClock + packetData->interPcketTime, 0, packetData);
+}
 
-        struct timeval curRemovePacketTime;
-        for(My402ListElem* cur = My402ListFirst(&Q1); cur != NULL; cur = My402ListNext(&Q1, cur)){
-            MyPacket* curPacket = (MyPacket*) cur->obj;
-            curPacket->packetType = 3;
+/*
+ * Single-threaded discrete-event version of the packet, token and server
+ * threads. Each idle server takes a packet from Q2 as soon as there is one,
+ * and SIGINT is polled between events.
+ */
+void runSimulation(){
+    MyPacket** serverPackets = (MyPacket**)calloc(numServers, sizeof(MyPacket*));
+    /* a token every 0us would never let the virtual clock move */
+    long long simInterTokenTime = interTokenTime > 0 ? interTokenTime : 1;
+    sigset_t pending;
+
+    if(serverPackets == NULL){
+        fprintf(stderr, "Error calloc in runSimulation.\n");
+        exit(1);
+    }
 
-            My402ListAppend(&outputQ, curPacket);
+    if(inputQSize > 0){
+        simSchedulePacket();
+    }
+    simSchedule(SIM_TOKEN, simInterTokenTime, 0, NULL);
 
-            gettimeofday(&curRemovePacketTime, NULL);
-            getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curRemovePacketTime));
+    for(long long eventNum = 0; simEventSize > 0; eventNum++){
+        SimEvent event = simNextEvent();
+        simClock = event.time;
 
-            fprintf(stdout, "%sms: p%lld removed from Q1\n", timeStampStr, curPacket->packetId);
+        if(eventNum % 1024 == 0 && sigpending(&pending) == 0 && sigismember(&pending, SIGINT)){
+            int mySignal = -1;
+            sigwait(&mask, &mySignal);
+            removeAllPackets();
         }
-        for(My402ListElem* cur = My402ListFirst(&Q2); cur != NULL; cur = My402ListNext(&Q2, cur)){
-            MyPacket* curPacket = (MyPacket*) cur->obj;
-            curPacket->packetType = 3;
-
-            My402ListAppend(&outputQ, curPacket);
 
-            gettimeofday(&curRemovePacketTime, NULL);
-            getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, curRemovePacketTime));
+        if(event.type == SIM_PACKET){
+            if(inputQSize > 0){
+                packetArrives((PacketData*)event.data);
+                if(inputQSize > 0){
+                    simSchedulePacket();
+                }
+            }
+            free(event.data);
+        }
+        else if(event.type == SIM_TOKEN){
+            if(inputQSize > 0 || !My402IListEmpty(&Q1)){
+                tokenArrives();
+                simSchedule(SIM_TOKEN, simClock + simInterTokenTime, 0, NULL);
+            }
+        }
+        else{
+            endService(serverPackets[event.server]);
+            serverPackets[event.server] = NULL;
+        }
 
-            fprintf(stdout, "%sms: p%lld removed from Q2\n", timeStampStr, curPacket->packetId);
+        for(int a = 0; a < numServers; a++){
+            if(serverPackets[a] == NULL){
+                if((serverPackets[a] = q2Get(FALSE)) == NULL){
+                    break;
+                }
+                beginService(serverPackets[a], serverIds[a]);
+                simSchedule(SIM_DEPART, simClock + serverPackets[a]->packetServiceTime, a, NULL);
+            }
         }
-        inputQSize = 0;
-        My402ListUnlinkAll(&Q1);
-        My402ListUnlinkAll(&Q2);
-        
-        pthread_cond_broadcast(&cv);
-        
-        pthread_mutex_unlock(&myLock);
     }
-    // fprintf(stdout, "inputQSize: %lld, Q1: %d, Q2: %d, outputQ: %d\n", inputQSize, My402ListLength(&Q1), My402ListLength(&Q2), My402ListLength(&outputQ));
-    // fprintf(stdout, "signal thread end!!!\n");
-    return NULL;
+    free(serverPackets);
 }
 
 int main(int argc, char* argv[]){
@@ -878,32 +1270,43 @@ int main(int argc, char* argv[]){
 
     printConfig(argc, argv);
 
-    gettimeofday(&emulationStartTime, NULL);
-    gettimeofday(&prePacketArriveTime, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &emulationStartTime);
+    prePacketArriveTime = 0;
 
     char timeStampStr[timeStampStrSize];
-    getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, emulationStartTime));
+    getTimeStampStr(timeStampStr, timeStampStrSize, curTime());
 
     fprintf(stdout, "%sms: emulation begins\n", timeStampStr);
 
-    pthread_create(&sig, NULL, signalFunc, "sig");
-    pthread_create(&packet, NULL, packetFunc, "packet");
-    pthread_create(&token, NULL, tokenFunc, "token");
-    pthread_create(&s1, NULL, serverFunc, "S1");
-    pthread_create(&s2, NULL, serverFunc, "S2");
+    if(simMode){
+        runSimulation();
+    }
+    else{
+        pthread_create(&sig, NULL, signalFunc, "sig");
+        pthread_create(&packet, NULL, packetFunc, "packet");
+        pthread_create(&token, NULL, tokenFunc, "token");
+        for(int a = 0; a < numServers; a++){
+            pthread_create(&servers[a], NULL, serverFunc, &serverIds[a]);
+        }
+
+        pthread_join(packet, NULL);
+        pthread_join(token, NULL);
+        for(int a = 0; a < numServers; a++){
+            pthread_join(servers[a], NULL);
+        }
+    }
 
-    pthread_join(packet, NULL);
-    pthread_join(token, NULL);
-    pthread_join(s1, NULL);
-    pthread_join(s2, NULL);
+    emulationEndTime = curTime();
 
-    gettimeofday(&emulationEndTime, NULL);
+    for(int a = 0; a < numServers; a++){
+        My402IListConcat(&outputQ, &servedQ[a]);
+    }
 
-    getTimeStampStr(timeStampStr, timeStampStrSize, calTimeDiff(emulationStartTime, emulationEndTime));
+    getTimeStampStr(timeStampStr, timeStampStrSize, emulationEndTime);
 
     fprintf(stdout, "%sms: emulation ends\n", timeStampStr);
 
     printStatics();
 
     cleanUp();
-}
\ No newline at end of file
+}